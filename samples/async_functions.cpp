@@ -0,0 +1,95 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * This is an sample file for v8bridge API interaction.
+ *
+ * This file provides a simple async functions demo.
+ * In this demo, we're exposing a slow native "fibonacci" function as an async function. Calling it from JS
+ * returns a promise immediately, while the function runs on the engine worker pool.
+ * The embedding loop pumps the engine tasks (runPending), which resolves the promises on the engine thread.
+ *
+ * Requires V8 6.0 or later (EngineOptions, promises).
+ */
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#define V8BRIDGE_DEBUG 1
+#include <v8bridge/v8bridge.hpp>
+#include <libplatform/libplatform.h>
+
+long fibonacci(int n)
+{
+    return n < 2 ? n : fibonacci(n - 1) + fibonacci(n - 2);
+}
+
+void print(std::string str)
+{
+    std::cout << str << std::endl;
+}
+
+int main(int argc, const char * argv[])
+{
+    using namespace v8::bridge;
+    
+    /* Initialize V8 */
+    std::unique_ptr<v8::Platform> platform = v8::platform::NewDefaultPlatform();
+    v8::V8::InitializePlatform(platform.get());
+    v8::V8::Initialize();
+    
+    {
+        EngineOptions options;
+        ScriptingEngine engine(options);
+        
+        /* Expose our functions */
+        NativeFunction *printFunction = new NativeFunction(engine.getActiveIsolationScope());
+        printFunction->addOverload(print);
+        engine.exposeFunction(printFunction, "print");
+        
+        engine.setAsyncWorkerPool(boost::shared_ptr<AsyncWorkerPool>(new AsyncWorkerPool(2)));
+        engine.exposeAsync(fibonacci, "fibonacci");
+        
+        /* Start two calls in parallel */
+        engine.execute("var pending = 2;"
+                       "fibonacci(35).then(function (n) { print('fibonacci(35) = ' + n); pending--; });"
+                       "fibonacci(30).then(function (n) { print('fibonacci(30) = ' + n); pending--; });"
+                       "print('Both calls were started');");
+        
+        /* The embedding loop */
+        while (engine.eval<int>("pending") > 0)
+        {
+            engine.runPending();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    
+    /* Done. */
+    v8::V8::Dispose();
+    return 0;
+}
@@ -0,0 +1,71 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * This is an sample file for v8bridge API interaction.
+ *
+ * This file provides a simple demonstration of the built-in console.
+ * The console messages are buffered and written by a background thread, so scripts don't block on the output.
+ * In this demo, we're routing the messages to our own sink, and reading the dropped messages count.
+ */
+
+#include <iostream>
+
+#define V8BRIDGE_DEBUG 1
+#include <v8bridge/v8bridge.hpp>
+
+void sink(v8::bridge::builtin::Console::Level level, const std::string &message)
+{
+    static const char *levels[] = { "log", "info", "warn", "error" };
+    std::cout << "[" << levels[level] << "] " << message << std::endl;
+}
+
+int main(int argc, const char * argv[])
+{
+    using namespace v8;
+    using namespace v8::bridge;
+    
+    /* Create the scripting engine (with the built-in declarations) */
+    ScriptingEngine *engine = new ScriptingEngine();
+    engine->setConsoleSink(sink);
+    
+    engine->execute(
+        "console.log('Hello', 'world', 1, 2, 3);"   // [log] Hello world 1 2 3
+        "console.warn('Something is odd:', [1, 2]);" // [warn] Something is odd: 1,2
+        "for (var i = 0; i < 100000; i++) console.info('message #' + i);"
+    );
+    
+    /* Wait for the messages to be written */
+    engine->getConsole()->flush();
+    std::cout << "Dropped: " << engine->getConsole()->getDroppedCount() << std::endl;
+    
+    /* Free */
+    delete engine;
+    
+    /* Done. */
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * This is an sample file for v8bridge API interaction.
+ *
+ * This file provides a simple demonstration of multiple contexts in a single engine.
+ * In this demo, we're exposing a "greet" function, then creating a context per tenant.
+ * Each tenant got its own global scope (so the "name" variable of one tenant is not visible to the other),
+ * while all of them share the exposed function and the isolation scope.
+ */
+
+#include <iostream>
+#include <sstream>
+
+#define V8BRIDGE_DEBUG 1
+#include <v8bridge/v8bridge.hpp>
+
+std::string greet(std::string name)
+{
+    return "Hello, " + name + "!";
+}
+
+int main(int argc, const char * argv[])
+{
+    using namespace v8;
+    using namespace v8::bridge;
+    
+    /* Create the scripting engine */
+    ScriptingEngine *engine = new ScriptingEngine();
+    Isolate *isolate = engine->getActiveIsolationScope();
+    
+    /* Expose our function. It will be installed in every context that we'll create */
+    NativeFunction *greetFunction = new NativeFunction(isolate);
+    greetFunction->addOverload(greet);
+    engine->exposeFunction(greetFunction, "greet");
+    
+    {
+        HandleScope handle_scope(isolate);
+        
+        /* Create a context per tenant */
+        Local<Context> first = engine->createContext();
+        Local<Context> second = engine->createContext();
+        
+        engine->execute(first, "var name = 'first tenant';");
+        engine->execute(second, "var name = 'second tenant';");
+        
+        std::cout << engine->eval<std::string>(first, "greet(name)") << std::endl;   // Hello, first tenant!
+        std::cout << engine->eval<std::string>(second, "greet(name)") << std::endl;  // Hello, second tenant!
+        
+        /* The engine own context doesn't see the tenants variables */
+        std::cout << engine->eval<std::string>("typeof name") << std::endl;          // undefined
+        
+        /* Release the tenants contexts once they're no longer used */
+        engine->releaseContext(first);
+        engine->releaseContext(second);
+    }
+    
+    /* Free */
+    delete engine;
+    
+    /* Done. */
+    return 0;
+}
@@ -0,0 +1,128 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * This is an sample file for v8bridge API interaction.
+ *
+ * This file provides a simple C++20 coroutines demo (see coroutine.hpp).
+ * In this demo, we're declaring an async JS function ("fetchUser"), which resolves once a timer expires,
+ * and awaiting it from a C++ coroutine. The embedding loop pumps the timers and the engine tasks, which resume the coroutine.
+ * We're also awaiting a rejected call, which is raised in the coroutine as an std::runtime_error.
+ *
+ * Requires a C++20 compiler and V8 6.6 or later.
+ */
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#define V8BRIDGE_DEBUG 1
+#include <v8bridge/v8bridge.hpp>
+#include <libplatform/libplatform.h>
+
+/* A minimal fire-and-forget coroutine type */
+struct task
+{
+    struct promise_type
+    {
+        task get_return_object() { return task(); }
+        std::suspend_never initial_suspend() { return std::suspend_never(); }
+        std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+        void return_void() { }
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+task print_user(v8::bridge::ScriptingEngine &engine, v8::bridge::UserlandFunction &fetchUser, int id, int &pending)
+{
+    try
+    {
+        std::string name = co_await engine.invokeAsync<std::string>(fetchUser, id);
+        std::cout << "User #" << id << ": " << name << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cout << "User #" << id << " failed: " << e.what() << std::endl;
+    }
+    
+    --pending;
+}
+
+int main(int argc, const char * argv[])
+{
+    using namespace v8::bridge;
+    
+    /* Initialize V8 */
+#if V8BRIDGE_V8_VERSION_AT_LEAST(7, 0)
+    std::unique_ptr<v8::Platform> platformHolder = v8::platform::NewDefaultPlatform();
+    v8::Platform *platform = platformHolder.get();
+#else
+    v8::Platform *platform = v8::platform::CreateDefaultPlatform();
+#endif
+    v8::V8::InitializePlatform(platform);
+    v8::V8::Initialize();
+    
+    {
+        EngineOptions options;
+        ScriptingEngine engine(options);
+        
+        /* Declare the async JS function */
+        engine.execute("async function fetchUser(id) {"
+                       "    await new Promise(function (resolve) { setTimeout(resolve, 10); });"
+                       "    if (id < 0) { throw new Error('invalid user id'); }"
+                       "    return 'user' + id;"
+                       "}");
+        
+        {
+            v8::HandleScope handle_scope(engine.getActiveIsolationScope());
+            UserlandFunction fetchUser(engine.getActiveIsolationScope(), engine.getFromGlobalScope("fetchUser"));
+            
+            /* Start the coroutines. Each one is suspended until its promise settles. */
+            int pending = 2;
+            print_user(engine, fetchUser, 1, pending);
+            print_user(engine, fetchUser, -1, pending);
+            
+            /* The embedding loop */
+            while (pending > 0)
+            {
+                engine.runTimers();
+                engine.runPending();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+    
+    /* Done. */
+    v8::V8::Dispose();
+#if !V8BRIDGE_V8_VERSION_AT_LEAST(7, 0)
+    delete platform;
+#endif
+    return 0;
+}
@@ -157,7 +157,6 @@ int main(int argc, const char * argv[])
     std::cout << "=========================================" << std::endl;
     
     /* Free */
-    delete carClass;
     delete engine;
     
     /* Done. */
@@ -33,7 +33,7 @@
  * Then, we're expsoing the Car class using v8bridge NativeClass interface.
  * Finally, we're creating in JS a new instance of Car, setting its color using the "color" property and invoking drive().
  *
- * Note: when "delete carClass;" is been called, the "car" instance that we've defined in JS is been removed
+ * Note: the exposed class is owned by the engine. When "delete engine;" is been called, the "car" instance that we've defined in JS is been removed
  * by v8bridge internal GC. For more details on why is this happing and why we need this, see internal_gc.hpp.
  */
 
@@ -117,8 +117,6 @@ int main(int argc, const char * argv[])
     engine->execute(io.str());
     
     /* Free */
-    delete printFunction;
-    delete fileUtilsClass;
     delete engine;
     
     /* Done. */
@@ -31,6 +31,7 @@
  * This file provides a simple functions usage demo.
  * In this demo, we're registering 3 functions:
  *      - add: A simple function that receives two numbers (int, int) and returns the addition result (int).
+ *          add is also exposed as a vectorized function - add.map(Int32Array, Int32Array) -> Int32Array.
  *      - multiply: A simple multiply function. This function gots two overloads,
  *          that we're exposing to JS. multiply(x) which multiply x by 2 and multiply(x, y) which multiplys x by y.
  *      - echo: A simple function thats echo the given string to stdout. This function, too, gots two overloads.
@@ -77,8 +78,10 @@ int main(int argc, const char * argv[])
     
     /* Add overloads */
     
-    // Add:
-    addFunction->addOverload(add);
+    // Add: we're also exposing add.map(Int32Array, Int32Array), which
+    // adds two arrays element by element in a single native call.
+    addFunction->addOverload(add)
+               ->exposeVectorized(add);
     
     // Multiply: Since the functions in C++ got the same name,
     // we must specify the function signature.
@@ -105,13 +108,12 @@ int main(int argc, const char * argv[])
     io << "echo('x * 2 (calling multiply(x)):', multiply(x));" << std::endl;
     io << "echo('========================================');" << std::endl;
     io << "echo('x * y (calling multiply(x, y)):', multiply(x, y));" << std::endl;
+    io << "echo('========================================');" << std::endl;
+    io << "echo('[1, 2, 3] + [4, 5, 6] (calling add.map(a, b)):', Array.prototype.join.call(add.map(new Int32Array([1, 2, 3]), new Int32Array([4, 5, 6]))));" << std::endl;
     
     engine->execute(io.str(), /* fileName: */ "functions.js");
     
     /* Free */
-    delete addFunction;
-    delete multiplyFunction;
-    delete echoFunction;
     delete engine;
     
     /* Done. */
@@ -31,11 +31,13 @@
  * This file provides a simple demonstration of invoking a JS callback from C++.
  * In this demo, we're declaring a simple filter_int_array (or filter_array) function, which aim is to
  * filter an array using a given callback. The supplied callback received from JS.
- * We're firing the callback using v8::bridge::invoke_v8_handle (or invoke_v8_handle_raw) set of functions.
+ * We're firing the callback using v8::bridge::invoke_v8_handle_many (or invoke_v8_handle_raw) set of functions.
  */
 
 #include <iostream>
+#include <iterator>
 #include <sstream>
+#include <vector>
 
 #define V8BRIDGE_DEBUG 1
 #include <v8bridge/v8bridge.hpp>
@@ -50,10 +52,24 @@ std::list<int> filter_int_array(std::list<int> array, Handle<Function> callback)
 {
     std::list<int> filteredArray;
     
-    for (std::list<int>::iterator it = array.begin(); it != array.end(); ++it)
+    /* Invoke the callback over the whole array at once (instead of calling invoke_v8_handle<bool> for each element) */
+    std::vector<char> flags;
+    flags.reserve(array.size());
+    
+    V8BRIDGE_TRY_CATCH(try_catch, Isolate::GetCurrent());
+    invoke_v8_handle_many<bool>(Isolate::GetCurrent(), callback, array.begin(), array.end(), std::back_inserter(flags));
+    
+    if (try_catch.HasCaught())
+    {
+        /* The callback has thrown: don't return a partial result, re-throw the exception to our JS caller instead */
+        try_catch.ReThrow();
+        return filteredArray;
+    }
+    
+    std::vector<char>::iterator flag = flags.begin();
+    for (std::list<int>::iterator it = array.begin(); it != array.end() && flag != flags.end(); ++it, ++flag)
     {
-        bool result = invoke_v8_handle<bool>(Isolate::GetCurrent(), callback, *it);
-        if (result)
+        if (*flag)
         {
             filteredArray.push_back(*it);
         }
@@ -110,7 +126,6 @@ int main(int argc, const char * argv[])
     std::cout << *output << std::endl;
     
     /* Free */
-    delete filterFunction;
     delete engine;
     
     /* Done. */
@@ -70,7 +70,6 @@ int main(int argc, const char * argv[])
     std::cout << "number_by_type('string'): " << engine->eval<std::string>("number_by_type('string')") << std::endl;
     
     /* Free */
-    delete function;
     delete engine;
     
     /* Done. */
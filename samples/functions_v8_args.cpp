@@ -81,7 +81,6 @@ int main(int argc, const char * argv[])
     std::cout << "add(1, 2, 2, 3): " << engine->eval<int>("add(1, 2, 2, 3)") << std::endl;
     
     /* Free */
-    delete addFunction;
     delete engine;
     
     /* Done. */
@@ -72,7 +72,6 @@ int main(int argc, const char * argv[])
     engine->execute("hello();", /* fileName: */ "hello_world.js");
     
     /* Free */
-    delete helloFunction;
     delete engine;
     
     /* Done. */
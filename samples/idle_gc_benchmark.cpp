@@ -0,0 +1,143 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * This is the idle time GC benchmark.
+ *
+ * The benchmark simulates a request loop with idle gaps between the requests. Each request evaluates a script
+ * that allocates short-lived objects. The loop is run twice:
+ *      - Without idle notifications: the gaps are just slept, so V8 collects garbage in the middle of the requests.
+ *      - With ScriptingEngine::onIdle: the gaps are handed to V8, so the garbage collection work is moved into them.
+ * For each run, the request latency percentiles are printed.
+ *
+ * Usage: idle_gc_benchmark [<requests count> [<idle gap in milliseconds>]]
+ *
+ * Requires V8 6.0 or later (EngineOptions, idle tasks).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <v8bridge/v8bridge.hpp>
+#include <libplatform/libplatform.h>
+
+typedef std::chrono::steady_clock TClock;
+
+static const int kWarmUpRequests = 100;
+
+/* Run the requests loop and return the sorted requests latencies (in microseconds) */
+std::vector<double> run(v8::Platform *platform, int requests, std::chrono::milliseconds gap, bool useIdleTime)
+{
+    using namespace v8::bridge;
+    
+    EngineOptions options;
+    ScriptingEngine engine(options);
+    engine.setIdleTaskPlatform(platform);
+    
+    std::string code =
+        "var items = [];"
+        "for (var i = 0; i < 20000; ++i) { items.push({ id: i, name: 'item' + i }); }"
+        "items.length;";
+    
+    std::vector<double> latencies;
+    latencies.reserve(requests);
+    
+    for (int i = 0; i < kWarmUpRequests + requests; ++i)
+    {
+        /* The request */
+        TClock::time_point start = TClock::now();
+        engine.eval<int>(code);
+        TClock::time_point end = TClock::now();
+        
+        if (i >= kWarmUpRequests)
+        {
+            latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+        }
+        
+        /* The idle gap */
+        TClock::time_point nextRequest = TClock::now() + gap;
+        if (useIdleTime)
+        {
+            engine.onIdle(nextRequest);
+        }
+        std::this_thread::sleep_until(nextRequest);
+    }
+    
+    std::sort(latencies.begin(), latencies.end());
+    return latencies;
+}
+
+double percentile(const std::vector<double> &sorted, double p)
+{
+    size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()));
+    return sorted[index];
+}
+
+void report(const char *title, const std::vector<double> &latencies)
+{
+    std::cout << title << ": "
+    << "p50 " << percentile(latencies, 0.50) << "us, "
+    << "p99 " << percentile(latencies, 0.99) << "us, "
+    << "max " << latencies.back() << "us" << std::endl;
+}
+
+int main(int argc, const char * argv[])
+{
+    int requests = argc > 1 ? std::atoi(argv[1]) : 2000;
+    std::chrono::milliseconds gap(argc > 2 ? std::atoi(argv[2]) : 5);
+    
+    if (requests < 1)
+    {
+        std::cerr << "Usage: " << argv[0] << " [<requests count> [<idle gap in milliseconds>]]" << std::endl;
+        return 1;
+    }
+    
+    /* Initialize V8, with idle tasks support (onIdle does nothing without an idle tasks platform) */
+#if V8BRIDGE_V8_VERSION_AT_LEAST(7, 0)
+    std::unique_ptr<v8::Platform> platformHolder = v8::platform::NewDefaultPlatform(0, v8::platform::IdleTaskSupport::kEnabled);
+    v8::Platform *platform = platformHolder.get();
+#else
+    v8::Platform *platform = v8::platform::CreateDefaultPlatform(0, v8::platform::IdleTaskSupport::kEnabled);
+#endif
+    v8::V8::InitializePlatform(platform);
+    v8::V8::Initialize();
+    
+    report("Without idle notifications", run(platform, requests, gap, false));
+    report("With onIdle               ", run(platform, requests, gap, true));
+    
+    /* Done. */
+    v8::V8::Dispose();
+#if !V8BRIDGE_V8_VERSION_AT_LEAST(7, 0)
+    delete platform;
+#endif
+    return 0;
+}
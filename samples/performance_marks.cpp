@@ -0,0 +1,70 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * This is an sample file for v8bridge API interaction.
+ *
+ * This file provides a simple demonstration of the built-in performance marks and measures.
+ * The script measures a section of its own code, while we're reading the aggregated durations histogram.
+ */
+
+#include <iostream>
+
+#define V8BRIDGE_DEBUG 1
+#include <v8bridge/v8bridge.hpp>
+
+int main(int argc, const char * argv[])
+{
+    using namespace v8;
+    using namespace v8::bridge;
+    
+    /* Create the scripting engine (with the built-in declarations) */
+    ScriptingEngine *engine = new ScriptingEngine();
+    
+    engine->execute(
+        "function fib(n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }"
+        "for (var i = 0; i < 100; i++) {"
+        "   performance.mark('fib');"
+        "   fib(15 + i % 10);"
+        "   performance.measure('fib', 'fib');"
+        "}"
+    );
+    
+    /* Read the aggregated histogram */
+    builtin::PerformanceHistogram fib = engine->getPerformance()->getHistograms()["fib"];
+    
+    std::cout << "Count: " << fib.count << std::endl;                   // 100
+    std::cout << "Mean: " << fib.mean() << "ms" << std::endl;
+    std::cout << "p99 (upper bound): " << fib.percentile(99) << "ms" << std::endl;
+    std::cout << "Max: " << fib.max << "ms" << std::endl;
+    
+    /* Free */
+    delete engine;
+    
+    /* Done. */
+    return 0;
+}
@@ -0,0 +1,195 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * This is the snapshot builder tool.
+ *
+ * The tool exposes a native "add" function, evaluates the given prelude scripts once and writes a V8 startup blob
+ * (see snapshot_builder.hpp). The tool also declares a "snapshotPreludes" global (the prelude file names) after the prelude scripts.
+ * Then, it verifies the blob by starting an engine from it, binding the native function again and checking that both
+ * the native function and the prelude globals are available.
+ *
+ * Usage: snapshot_builder <output.blob> <prelude.js> [<prelude.js> ...]
+ *
+ * Requires V8 6.8 or later (SnapshotCreator::AddData).
+ */
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include <v8bridge/v8bridge.hpp>
+#include <libplatform/libplatform.h>
+
+/* The native function that is part of the snapshot */
+int add(int x, int y) { return x + y; }
+
+/* Quote the given string as a JS string literal */
+std::string quote(const std::string &str)
+{
+    std::string quoted = "\"";
+    for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+    {
+        if (*it == '"' || *it == '\\')
+        {
+            quoted += '\\';
+        }
+        quoted += *it;
+    }
+    
+    return quoted + "\"";
+}
+
+/* Create (and configure) the snapshot native endpoints.
+    Both the builder and the startup code should create the endpoints in the same order. */
+v8::bridge::NativeFunction *createAddFunction(v8::Isolate *isolationScope)
+{
+    v8::bridge::NativeFunction *addFunction = new v8::bridge::NativeFunction(isolationScope);
+    addFunction->addOverload(add);
+    return addFunction;
+}
+
+int main(int argc, const char * argv[])
+{
+    using namespace v8::bridge;
+    
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <output.blob> <prelude.js> [<prelude.js> ...]" << std::endl;
+        return 1;
+    }
+    
+    /* Initialize V8 */
+#if V8BRIDGE_V8_VERSION_AT_LEAST(7, 0)
+    std::unique_ptr<v8::Platform> platform = v8::platform::NewDefaultPlatform();
+    v8::V8::InitializePlatform(platform.get());
+#else
+    v8::Platform *platform = v8::platform::CreateDefaultPlatform();
+    v8::V8::InitializePlatform(platform);
+#endif
+    v8::V8::Initialize();
+    
+    int status = 0;
+    
+    try
+    {
+        /* The bindings must be configured the same way when building the snapshot and when starting from it */
+        SnapshotBindings builderBindings;
+        SnapshotBuilder builder(&builderBindings);
+        
+        /* Expose the native endpoints */
+        {
+            v8::HandleScope handle_scope(builder.getIsolate());
+            builder.expose(createAddFunction(builder.getIsolate()), "add");
+        }
+        
+        /* Collect the prelude scripts */
+        std::stringstream preludes;
+        for (int i = 2; i < argc; ++i)
+        {
+            std::ifstream file(argv[i]);
+            if (!file)
+            {
+                std::cerr << "Could not read " << argv[i] << std::endl;
+                return 1;
+            }
+            
+            std::stringstream io;
+            io << file.rdbuf();
+            builder.addScript(io.str(), argv[i]);
+            preludes << (i > 2 ? ", " : "") << quote(argv[i]);
+        }
+        
+        /* Declare a global that is evaluated after the preludes, so we can check that the prelude state survived the snapshot */
+        builder.addScript("var snapshotPreludes = [" + preludes.str() + "];", "snapshot_preludes.js");
+        
+        /* Build and save the blob */
+        SnapshotBlob *blob = builder.build();
+        if (blob->save(argv[1]))
+        {
+            std::cout << "Wrote " << blob->size() << " bytes to " << argv[1] << std::endl;
+        }
+        else
+        {
+            std::cerr << "Could not write " << argv[1] << std::endl;
+            status = 1;
+        }
+        
+        /* Verify the blob: start an engine from it and bind "add" again */
+        SnapshotBindings bindings;
+        
+        EngineOptions options;
+        options.snapshotBlob = blob->get();
+        options.externalReferences = bindings.getExternalReferences();
+        
+        ScriptingEngine *engine = new ScriptingEngine(options);
+        {
+            v8::HandleScope handle_scope(engine->getActiveIsolationScope());
+            
+            bindings.attach(engine->getActiveIsolationScope());
+            NativeFunction *addFunction = createAddFunction(engine->getActiveIsolationScope());
+            bindings.restore();
+            
+            engine->exposeFunction(addFunction, "add");
+        }
+        
+        std::stringstream check;
+        check << "Array.isArray(snapshotPreludes) && snapshotPreludes.length === " << (argc - 2);
+        
+        if (!engine->eval<bool>("typeof add === 'function' && add(2, 3) === 5", /* fileName: */ "verify_bindings.js"))
+        {
+            std::cerr << "The snapshot native function is not bound." << std::endl;
+            status = 1;
+        }
+        else if (!engine->eval<bool>(check.str(), /* fileName: */ "verify_preludes.js"))
+        {
+            std::cerr << "The snapshot prelude globals are missing." << std::endl;
+            status = 1;
+        }
+        else
+        {
+            std::cout << "Verified " << bindings.size() << " native binding(s) and " << (argc - 2) << " prelude(s)" << std::endl;
+        }
+        
+        delete engine;
+        delete blob;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        status = 1;
+    }
+    
+    /* Done. */
+    v8::V8::Dispose();
+#if !V8BRIDGE_V8_VERSION_AT_LEAST(7, 0)
+    delete platform;
+#endif
+    return status;
+}
@@ -0,0 +1,79 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * This is an sample file for v8bridge API interaction.
+ *
+ * This file provides a simple demonstration of the built-in timers (setTimeout, setInterval, clearTimeout and clearInterval).
+ * The timers are driven by our loop: we're calling runTimers until there are no more pending timers.
+ */
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+
+#define V8BRIDGE_DEBUG 1
+#include <v8bridge/v8bridge.hpp>
+
+int main(int argc, const char * argv[])
+{
+    using namespace v8;
+    using namespace v8::bridge;
+    
+    /* Create the scripting engine (with the built-in declarations) */
+    ScriptingEngine *engine = new ScriptingEngine();
+    
+    engine->execute(
+        "var ticks = 0, fired = 0;"
+        "var interval = setInterval(function () {"
+        "   if (++ticks == 5) clearInterval(interval);"
+        "}, 10);"
+        ""
+        "/* Schedule plenty of timers, then cancel half of them */"
+        "var ids = [];"
+        "for (var i = 0; i < 20000; i++) {"
+        "   ids.push(setTimeout(function (n) { fired += n; }, i % 100, 1));"
+        "}"
+        "for (var i = 0; i < ids.length; i += 2) clearTimeout(ids[i]);"
+    );
+    
+    /* Our event loop */
+    while (engine->hasPendingTimers())
+    {
+        engine->runTimers();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    
+    std::cout << "Ticks: " << engine->eval<int>("ticks") << std::endl;  // 5
+    std::cout << "Fired: " << engine->eval<int>("fired") << std::endl;  // 10000
+    
+    /* Free */
+    delete engine;
+    
+    /* Done. */
+    return 0;
+}
@@ -0,0 +1,137 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef v8bridge_async_worker_pool_hpp
+#define v8bridge_async_worker_pool_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <boost/function.hpp>
+
+namespace v8
+{
+    namespace bridge
+    {
+        /**
+         * A fixed-size pool of worker threads, used to run the native side of async functions
+         * (see ScriptingEngine::exposeAsync). A pool may be shared by several engines.
+         *
+         * The workers never touch V8: the jobs results are posted back to the engine thread.
+         */
+        class V8_DECL AsyncWorkerPool
+        {
+        public:
+            typedef boost::function<void ()> TJob;
+            
+            /**
+             * @param workersCount - the number of worker threads (0 uses the number of hardware threads).
+             */
+            AsyncWorkerPool(size_t workersCount = 0) : m_stopping(false)
+            {
+                if (workersCount == 0)
+                {
+                    workersCount = std::max(1u, std::thread::hardware_concurrency());
+                }
+                
+                for (size_t i = 0; i < workersCount; ++i)
+                {
+                    this->m_workers.push_back(std::thread(&AsyncWorkerPool::run, this));
+                }
+            }
+            
+            /**
+             * Waits for the submitted jobs to complete.
+             */
+            ~AsyncWorkerPool()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(this->m_mutex);
+                    this->m_stopping = true;
+                }
+                this->m_condition.notify_all();
+                
+                for (std::vector<std::thread>::iterator it = this->m_workers.begin(); it != this->m_workers.end(); ++it)
+                {
+                    it->join();
+                }
+            }
+            
+            inline void submit(const TJob &job)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(this->m_mutex);
+                    this->m_jobs.push_back(job);
+                }
+                this->m_condition.notify_one();
+            }
+            
+            inline size_t getWorkersCount() const { return this->m_workers.size(); }
+        private:
+            AsyncWorkerPool(const AsyncWorkerPool &);
+            AsyncWorkerPool &operator=(const AsyncWorkerPool &);
+            
+            inline void run()
+            {
+                for (;;)
+                {
+                    TJob job;
+                    {
+                        std::unique_lock<std::mutex> lock(this->m_mutex);
+                        while (this->m_jobs.empty() && !this->m_stopping)
+                        {
+                            this->m_condition.wait(lock);
+                        }
+                        
+                        if (this->m_jobs.empty())
+                        {
+                            return; // stopping
+                        }
+                        
+                        job = this->m_jobs.front();
+                        this->m_jobs.pop_front();
+                    }
+                    
+                    job();
+                }
+            }
+            
+            std::mutex m_mutex;
+            std::condition_variable m_condition;
+            std::deque<TJob> m_jobs;
+            std::vector<std::thread> m_workers;
+            bool m_stopping;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,246 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef v8bridge_builtin_console_hpp
+#define v8bridge_builtin_console_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
+
+#include <v8bridge/detail/spsc_ring.hpp>
+
+#ifndef V8BRIDGE_CONSOLE_BUFFER_SIZE
+#   define V8BRIDGE_CONSOLE_BUFFER_SIZE (256 * 1024)
+#endif
+
+namespace v8
+{
+    namespace bridge
+    {
+        namespace builtin
+        {
+            /**
+             * The engine console (console.log, console.info, console.warn and console.error).
+             *
+             * The messages are formatted on the engine thread into a lock-free ring buffer, and written to the sink
+             * by a background writer thread, so logging never blocks the scripts on the output streams.
+             * When the buffer is full (the sink can't keep up), messages are dropped and counted (see getDroppedCount).
+             */
+            class V8_DECL Console
+            {
+            public:
+                enum Level { kLog = 0, kInfo, kWarn, kError };
+                
+                typedef boost::function<void (Level, const std::string &)> TSink;
+                
+                Console(size_t bufferSize = V8BRIDGE_CONSOLE_BUFFER_SIZE) :
+                m_buffer(bufferSize),
+                m_sink(&Console::StandardSink),
+                m_pushedCount(0),
+                m_writtenCount(0),
+                m_droppedCount(0),
+                m_running(false),
+                m_writerWaiting(false) { }
+                
+                ~Console()
+                {
+                    if (this->m_writer.joinable())
+                    {
+                        /* The writer drains the buffer before it stops */
+                        this->m_running.store(false, boost::memory_order_release);
+                        this->m_wakeup.notify_one();
+                        this->m_writer.join();
+                    }
+                }
+                
+                /**
+                 * Set the messages sink. The sink is called by the writer thread, one message at a time.
+                 */
+                inline void setSink(const TSink &sink)
+                {
+                    std::lock_guard<std::mutex> lock(this->m_sinkMutex);
+                    this->m_sink = sink;
+                }
+                
+                /**
+                 * Queue the given message. Should be called by the engine thread only.
+                 * Returns false if the message was dropped, since the buffer is full.
+                 */
+                inline bool write(Level level, const std::string &message)
+                {
+                    if (!this->m_buffer.push(static_cast<boost::uint32_t>(level), message.data(), static_cast<boost::uint32_t>(message.size())))
+                    {
+                        this->m_droppedCount.fetch_add(1, boost::memory_order_relaxed);
+                        return false;
+                    }
+                    
+                    ++this->m_pushedCount;
+                    
+                    if (!this->m_writer.joinable())
+                    {
+                        /* The writer is started lazily, so engines that never log don't pay for a thread */
+                        this->m_running.store(true, boost::memory_order_release);
+                        this->m_writer = std::thread(&Console::writerLoop, this);
+                    }
+                    else if (this->m_writerWaiting.load(boost::memory_order_acquire))
+                    {
+                        /* We're not taking the lock, a missed wakeup only delays the writer until its wait times out */
+                        this->m_wakeup.notify_one();
+                    }
+                    
+                    return true;
+                }
+                
+                /**
+                 * Wait until all the queued messages were written to the sink. Should be called by the engine thread only.
+                 */
+                inline void flush()
+                {
+                    while (this->m_writtenCount.load(boost::memory_order_acquire) < this->m_pushedCount)
+                    {
+                        this->m_wakeup.notify_one();
+                        std::this_thread::yield();
+                    }
+                }
+                
+                /**
+                 * Get the number of messages that were dropped, since the buffer was full.
+                 */
+                inline boost::uint64_t getDroppedCount() const
+                {
+                    return this->m_droppedCount.load(boost::memory_order_relaxed);
+                }
+                
+                /**
+                 * The default sink. Writes log and info messages to the standard output, and warnings and errors to the standard error.
+                 */
+                inline static void StandardSink(Level level, const std::string &message)
+                {
+                    std::ostream &stream = level >= kWarn ? std::cerr : std::cout;
+                    stream << message << '\n';
+                }
+                
+                //-------------------------------------------------
+                //  JS endpoints (the data is the Console instance)
+                //-------------------------------------------------
+                
+                template <Level level>
+                inline static void WriteCallback(const FunctionCallbackInfo<Value>& info)
+                {
+                    Console *self = static_cast<Console *>(External::Cast(*info.Data())->Value());
+                    
+                    /* Arguments are converted to strings and joined by spaces */
+                    std::string message;
+                    for (int i = 0; i < info.Length(); ++i)
+                    {
+                        if (i > 0)
+                        {
+                            message += ' ';
+                        }
+                        
+                        String::Utf8Value value(info[i]);
+                        if (*value)
+                        {
+                            message.append(*value, value.length());
+                        }
+                        else
+                        {
+                            message += "<string conversion failed>";
+                        }
+                    }
+                    
+                    self->write(level, message);
+                }
+            private:
+                Console(const Console &);
+                Console &operator=(const Console &);
+                
+                inline void writerLoop()
+                {
+                    std::string message;
+                    boost::uint32_t level;
+                    
+                    while (true)
+                    {
+                        /* Read the flag before draining, so messages queued before stopping are written */
+                        bool stopping = !this->m_running.load(boost::memory_order_acquire);
+                        
+                        while (this->m_buffer.pop(level, message))
+                        {
+                            {
+                                std::lock_guard<std::mutex> lock(this->m_sinkMutex);
+                                this->m_sink(static_cast<Level>(level), message);
+                            }
+                            
+                            this->m_writtenCount.fetch_add(1, boost::memory_order_release);
+                        }
+                        
+                        if (stopping)
+                        {
+                            break;
+                        }
+                        
+                        std::unique_lock<std::mutex> lock(this->m_wakeupMutex);
+                        this->m_writerWaiting.store(true, boost::memory_order_release);
+                        
+                        if (this->m_buffer.empty() && this->m_running.load(boost::memory_order_acquire))
+                        {
+                            this->m_wakeup.wait_for(lock, std::chrono::milliseconds(10));
+                        }
+                        
+                        this->m_writerWaiting.store(false, boost::memory_order_release);
+                    }
+                }
+                
+                detail::SPSCRingBuffer m_buffer;
+                TSink m_sink;
+                std::mutex m_sinkMutex;
+                
+                boost::uint64_t m_pushedCount; // Touched by the engine thread only
+                boost::atomic<boost::uint64_t> m_writtenCount;
+                boost::atomic<boost::uint64_t> m_droppedCount;
+                
+                std::thread m_writer;
+                boost::atomic<bool> m_running;
+                boost::atomic<bool> m_writerWaiting;
+                std::mutex m_wakeupMutex;
+                std::condition_variable m_wakeup;
+            };
+        }
+    }
+}
+
+#endif
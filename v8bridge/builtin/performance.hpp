@@ -0,0 +1,342 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef v8bridge_builtin_performance_hpp
+#define v8bridge_builtin_performance_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <map>
+#include <string>
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+
+#ifndef V8BRIDGE_PERFORMANCE_MAX_ENTRIES
+#   define V8BRIDGE_PERFORMANCE_MAX_ENTRIES 1024
+#endif
+
+namespace v8
+{
+    namespace bridge
+    {
+        namespace builtin
+        {
+            /**
+             * An aggregated histogram of a performance measure durations.
+             * Durations are bucketed by powers of two microseconds (bucket i holds durations in [2^(i-1), 2^i) microseconds).
+             */
+            struct V8_DECL PerformanceHistogram
+            {
+                enum { kBuckets = 40 };
+                
+                PerformanceHistogram() : count(0), total(0), min(std::numeric_limits<double>::max()), max(0)
+                {
+                    for (int i = 0; i < kBuckets; ++i)
+                    {
+                        this->buckets[i] = 0;
+                    }
+                }
+                
+                /**
+                 * Record the given duration, in milliseconds. Negative durations (e.g. a measure whose end mark precedes its start mark)
+                 * and NaN are recorded as 0.
+                 */
+                inline void record(double duration)
+                {
+                    if (!(duration > 0)) // also handles NaN
+                    {
+                        duration = 0;
+                    }
+                    
+                    ++this->count;
+                    this->total += duration;
+                    this->min = std::min(this->min, duration);
+                    this->max = std::max(this->max, duration);
+                    
+                    /* The bucket is the bit length of the duration in microseconds (computed on the double, so huge durations can't overflow) */
+                    double microseconds = duration * 1000;
+                    int bucket = 0;
+                    while (microseconds >= 1 && bucket < kBuckets - 1)
+                    {
+                        microseconds /= 2;
+                        ++bucket;
+                    }
+                    
+                    ++this->buckets[bucket];
+                }
+                
+                inline double mean() const
+                {
+                    return this->count > 0 ? this->total / this->count : 0;
+                }
+                
+                /**
+                 * Get an upper bound of the given percentile (0 - 100) of the recorded durations, in milliseconds.
+                 */
+                inline double percentile(double p) const
+                {
+                    if (this->count == 0)
+                    {
+                        return 0;
+                    }
+                    
+                    boost::uint64_t rank = static_cast<boost::uint64_t>(this->count * p / 100);
+                    boost::uint64_t seen = 0;
+                    for (int i = 0; i < kBuckets; ++i)
+                    {
+                        seen += this->buckets[i];
+                        if (seen > rank)
+                        {
+                            return std::min(static_cast<double>(boost::uint64_t(1) << i) / 1000, this->max);
+                        }
+                    }
+                    
+                    return this->max;
+                }
+                
+                boost::uint64_t count;
+                double total; // All the durations are in milliseconds
+                double min;
+                double max;
+                boost::uint64_t buckets[kBuckets];
+            };
+            
+            /**
+             * The engine performance object (performance.now, mark, measure, clearMarks and clearMeasures).
+             *
+             * Time is read from a monotonic clock, in milliseconds (with sub-millisecond precision) since the engine creation.
+             * Marks and measures are recorded by the engine thread into native buffers, instead of allocating JS entries:
+             * each measure name aggregates its durations into a PerformanceHistogram, which can be read by the embedder (see getHistograms),
+             * so in-script profiling is cheap enough to be kept on in production.
+             *
+             * The buffers are bounded by V8BRIDGE_PERFORMANCE_MAX_ENTRIES names, further names are ignored.
+             * Note that the buffers should only be accessed by the engine thread.
+             *
+             * Example:
+             *      JS:  performance.mark('render'); render(); performance.measure('render', 'render');
+             *      C++: double p99 = engine->getPerformance()->getHistograms()["render"].percentile(99);
+             */
+            class V8_DECL Performance
+            {
+            public:
+                typedef std::chrono::steady_clock TClock;
+                typedef std::map<std::string, PerformanceHistogram> THistogramsMap;
+                
+                Performance() : m_origin(TClock::now()) { }
+                
+                /**
+                 * Get the time since the engine creation, in milliseconds.
+                 */
+                inline double now() const
+                {
+                    return std::chrono::duration<double, std::milli>(TClock::now() - this->m_origin).count();
+                }
+                
+                /**
+                 * Record the current time as the given mark. Returns the mark time.
+                 */
+                inline double mark(const std::string &name)
+                {
+                    double time = this->now();
+                    
+                    TMarksMap::iterator it = this->m_marks.find(name);
+                    if (it != this->m_marks.end())
+                    {
+                        it->second = time;
+                    }
+                    else if (this->m_marks.size() < V8BRIDGE_PERFORMANCE_MAX_ENTRIES)
+                    {
+                        this->m_marks.insert(std::make_pair(name, time));
+                    }
+                    
+                    return time;
+                }
+                
+                /**
+                 * Get the time of the given mark. Returns false if there's no such mark.
+                 */
+                inline bool getMark(const std::string &name, double &time) const
+                {
+                    TMarksMap::const_iterator it = this->m_marks.find(name);
+                    if (it == this->m_marks.end())
+                    {
+                        return false;
+                    }
+                    
+                    time = it->second;
+                    return true;
+                }
+                
+                /**
+                 * Record the given duration (in milliseconds) into the given measure histogram.
+                 */
+                inline void measure(const std::string &name, double duration)
+                {
+                    TMeasuresMap::iterator it = this->m_measures.find(name);
+                    if (it == this->m_measures.end())
+                    {
+                        if (this->m_measures.size() >= V8BRIDGE_PERFORMANCE_MAX_ENTRIES)
+                        {
+                            return;
+                        }
+                        
+                        it = this->m_measures.insert(std::make_pair(name, PerformanceHistogram())).first;
+                    }
+                    
+                    it->second.record(duration);
+                }
+                
+                /**
+                 * Get a copy of the measures histograms, by the measures names.
+                 */
+                inline THistogramsMap getHistograms() const
+                {
+                    return THistogramsMap(this->m_measures.begin(), this->m_measures.end());
+                }
+                
+                inline void clearMarks() { this->m_marks.clear(); }
+                inline void clearMeasures() { this->m_measures.clear(); }
+                
+                /* Clear the given mark (or measure histogram) only */
+                inline void clearMarks(const std::string &name) { this->m_marks.erase(name); }
+                inline void clearMeasures(const std::string &name) { this->m_measures.erase(name); }
+                
+                //-------------------------------------------------
+                //  JS endpoints (the data is the Performance instance)
+                //-------------------------------------------------
+                
+                /* performance.now() */
+                inline static void NowCallback(const FunctionCallbackInfo<Value>& info)
+                {
+                    info.GetReturnValue().Set(Performance::FromData(info)->now());
+                }
+                
+                /* performance.mark(name) */
+                inline static void MarkCallback(const FunctionCallbackInfo<Value>& info)
+                {
+                    if (info.Length() < 1)
+                    {
+                        info.GetIsolate()->ThrowException(v8::Exception::TypeError(String::NewFromUtf8(info.GetIsolate(), "The mark name is required.")));
+                        return;
+                    }
+                    
+                    String::Utf8Value name(info[0]);
+                    info.GetReturnValue().Set(Performance::FromData(info)->mark(*name ? *name : ""));
+                }
+                
+                /* performance.measure(name[, startMark[, endMark]]). Returns the measured duration. */
+                inline static void MeasureCallback(const FunctionCallbackInfo<Value>& info)
+                {
+                    Performance *self = Performance::FromData(info);
+                    
+                    if (info.Length() < 1)
+                    {
+                        info.GetIsolate()->ThrowException(v8::Exception::TypeError(String::NewFromUtf8(info.GetIsolate(), "The measure name is required.")));
+                        return;
+                    }
+                    
+                    /* The measure starts at the engine creation and ends now, unless marks are given */
+                    double start = 0;
+                    double end = self->now();
+                    
+                    if ((info.Length() > 1 && !info[1]->IsUndefined() && !Performance::ResolveMark(info, info[1], start))
+                        || (info.Length() > 2 && !info[2]->IsUndefined() && !Performance::ResolveMark(info, info[2], end)))
+                    {
+                        return;
+                    }
+                    
+                    String::Utf8Value name(info[0]);
+                    self->measure(*name ? *name : "", end - start);
+                    
+                    info.GetReturnValue().Set(end - start);
+                }
+                
+                /* performance.clearMarks([name]) */
+                inline static void ClearMarksCallback(const FunctionCallbackInfo<Value>& info)
+                {
+                    if (info.Length() > 0 && !info[0]->IsUndefined())
+                    {
+                        String::Utf8Value name(info[0]);
+                        Performance::FromData(info)->clearMarks(*name ? *name : "");
+                        return;
+                    }
+                    
+                    Performance::FromData(info)->clearMarks();
+                }
+                
+                /* performance.clearMeasures([name]) */
+                inline static void ClearMeasuresCallback(const FunctionCallbackInfo<Value>& info)
+                {
+                    if (info.Length() > 0 && !info[0]->IsUndefined())
+                    {
+                        String::Utf8Value name(info[0]);
+                        Performance::FromData(info)->clearMeasures(*name ? *name : "");
+                        return;
+                    }
+                    
+                    Performance::FromData(info)->clearMeasures();
+                }
+            private:
+                typedef boost::unordered_map<std::string, double> TMarksMap;
+                typedef boost::unordered_map<std::string, PerformanceHistogram> TMeasuresMap;
+                
+                Performance(const Performance &);
+                Performance &operator=(const Performance &);
+                
+                inline static Performance *FromData(const FunctionCallbackInfo<Value>& info)
+                {
+                    return static_cast<Performance *>(External::Cast(*info.Data())->Value());
+                }
+                
+                /**
+                 * Resolve the time of the given mark name. Throws a JS error and returns false if there's no such mark.
+                 */
+                inline static bool ResolveMark(const FunctionCallbackInfo<Value>& info, Local<Value> mark, double &time)
+                {
+                    String::Utf8Value name(mark);
+                    if (*name && Performance::FromData(info)->getMark(*name, time))
+                    {
+                        return true;
+                    }
+                    
+                    std::string message = std::string("The mark '") + (*name ? *name : "") + "' does not exist.";
+                    info.GetIsolate()->ThrowException(v8::Exception::SyntaxError(String::NewFromUtf8(info.GetIsolate(), message.c_str())));
+                    return false;
+                }
+                
+                TClock::time_point m_origin;
+                TMarksMap m_marks;
+                TMeasuresMap m_measures;
+            };
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,339 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef v8bridge_builtin_timers_hpp
+#define v8bridge_builtin_timers_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <v8bridge/detail/timing_wheel.hpp>
+
+namespace v8
+{
+    namespace bridge
+    {
+        namespace builtin
+        {
+            /**
+             * The engine timers (setTimeout, setInterval, clearTimeout and clearInterval).
+             *
+             * The timers are kept in a hierarchical timing wheel with a millisecond tick, so scheduling and cancelling are O(1)
+             * and many thousands of pending timers cost no threads. The wheel is driven by the embedder loop (see ScriptingEngine::runTimers),
+             * and the callbacks are invoked on the engine thread, in the context they were scheduled from.
+             */
+            class V8_DECL Timers
+            {
+            public:
+                typedef std::chrono::steady_clock TClock;
+                
+                Timers(Isolate *isolationScope) : m_isolationScope(isolationScope), m_epoch(TClock::now()), m_wheel(0), m_nextId(1) { }
+                
+                ~Timers()
+                {
+                    this->clear();
+                }
+                
+                /**
+                 * Schedule the given callback to be called (with the given arguments) after the given delay, in milliseconds.
+                 * Returns the timer id.
+                 */
+                inline boost::uint32_t schedule(Handle<Context> context, Handle<Function> callback, boost::uint64_t delay, bool repeat,
+                                                const std::vector<Handle<Value> > &args = std::vector<Handle<Value> >())
+                {
+                    Timer *timer = new Timer();
+                    timer->id = this->allocateId();
+                    timer->interval = repeat ? std::max<boost::uint64_t>(delay, 1) : 0;
+                    timer->context.Reset(this->m_isolationScope, context);
+                    timer->callback.Reset(this->m_isolationScope, callback);
+                    
+                    for (std::vector<Handle<Value> >::const_iterator it = args.begin(); it != args.end(); ++it)
+                    {
+                        timer->args.push_back(TPersistentValue(this->m_isolationScope, *it));
+                    }
+                    
+                    this->m_wheel.schedule(timer, this->tick(TClock::now()) + delay);
+                    this->m_timers.insert(std::make_pair(timer->id, timer));
+                    
+                    return timer->id;
+                }
+                
+                /**
+                 * Cancel the given timer. Returns false if there's no such pending timer.
+                 */
+                inline bool cancel(boost::uint32_t id)
+                {
+                    TTimersMap::iterator it = this->m_timers.find(id);
+                    if (it == this->m_timers.end())
+                    {
+                        return false;
+                    }
+                    
+                    Timer *timer = it->second;
+                    this->m_timers.erase(it);
+                    this->cancelTimer(timer);
+                    
+                    return true;
+                }
+                
+                /**
+                 * Call the callbacks of the timers that expired until the given time. Returns the number of called callbacks.
+                 */
+                inline size_t run(TClock::time_point now)
+                {
+                    std::vector<detail::TimerNode *> expired;
+                    boost::uint64_t currentTick = this->tick(now);
+                    this->m_wheel.advance(currentTick, expired);
+                    
+                    size_t count = 0;
+                    for (std::vector<detail::TimerNode *>::iterator it = expired.begin(); it != expired.end(); ++it)
+                    {
+                        Timer *timer = static_cast<Timer *>(*it);
+                        if (timer->cancelled)
+                        {
+                            this->release(timer);
+                            continue;
+                        }
+                        
+                        HandleScope handle_scope(this->m_isolationScope);
+                        
+                        Local<Context> context = Local<Context>::New(this->m_isolationScope, timer->context);
+                        Local<Function> callback = Local<Function>::New(this->m_isolationScope, timer->callback);
+                        
+                        std::vector<Local<Value> > argv;
+                        for (TArgsList::iterator arg = timer->args.begin(); arg != timer->args.end(); ++arg)
+                        {
+                            argv.push_back(Local<Value>::New(this->m_isolationScope, *arg));
+                        }
+                        
+                        /* Intervals are rescheduled before the call, so they can be cleared by their own callback.
+                            Timeouts are released, since they may not be used after the call. */
+                        if (timer->interval > 0)
+                        {
+                            this->m_wheel.schedule(timer, currentTick + timer->interval);
+                        }
+                        else
+                        {
+                            this->m_timers.erase(timer->id);
+                            this->release(timer);
+                        }
+                        
+                        Context::Scope context_scope(context);
+                        V8BRIDGE_TRY_CATCH(try_catch, this->m_isolationScope);
+                        callback->Call(context->Global(), static_cast<int>(argv.size()), argv.empty() ? NULL : &argv[0]);
+                        
+                        ++count;
+                    }
+                    
+                    return count;
+                }
+                
+                /**
+                 * Cancel all the pending timers.
+                 */
+                inline void clear()
+                {
+                    for (TTimersMap::iterator it = this->m_timers.begin(); it != this->m_timers.end(); ++it)
+                    {
+                        this->cancelTimer(it->second);
+                    }
+                    
+                    this->m_timers.clear();
+                }
+                
+                /**
+                 * Cancel the pending timers that were scheduled from the given context (e.g. once the context is discarded).
+                 * The timers of the other contexts are kept.
+                 */
+                inline void clear(Handle<Context> context)
+                {
+                    HandleScope handle_scope(this->m_isolationScope);
+                    
+                    for (TTimersMap::iterator it = this->m_timers.begin(); it != this->m_timers.end(); )
+                    {
+                        Timer *timer = it->second;
+                        if (Local<Context>::New(this->m_isolationScope, timer->context) != context)
+                        {
+                            ++it;
+                            continue;
+                        }
+                        
+                        it = this->m_timers.erase(it);
+                        this->cancelTimer(timer);
+                    }
+                }
+                
+                inline size_t size() const { return this->m_timers.size(); }
+                
+                //-------------------------------------------------
+                //  JS endpoints (the data is the Timers instance)
+                //-------------------------------------------------
+                
+                /* setTimeout(callback, delay, ...args) */
+                inline static void SetTimeoutCallback(const FunctionCallbackInfo<Value>& info)
+                {
+                    Timers::Schedule(info, false);
+                }
+                
+                /* setInterval(callback, delay, ...args) */
+                inline static void SetIntervalCallback(const FunctionCallbackInfo<Value>& info)
+                {
+                    Timers::Schedule(info, true);
+                }
+                
+                /* clearTimeout(id), clearInterval(id) */
+                inline static void ClearCallback(const FunctionCallbackInfo<Value>& info)
+                {
+                    Timers *self = static_cast<Timers *>(External::Cast(*info.Data())->Value());
+                    
+                    if (info.Length() > 0 && info[0]->IsUint32())
+                    {
+                        self->cancel(info[0]->Uint32Value());
+                    }
+                }
+            private:
+                typedef Persistent<Value, CopyablePersistentTraits<Value> > TPersistentValue;
+                typedef std::vector<TPersistentValue> TArgsList;
+                
+                struct Timer : public detail::TimerNode
+                {
+                    Timer() : id(0), interval(0), cancelled(false) { }
+                    
+                    boost::uint32_t id;
+                    boost::uint64_t interval;
+                    bool cancelled;
+                    Persistent<Context> context;
+                    Persistent<Function> callback;
+                    TArgsList args;
+                };
+                
+                typedef boost::unordered_map<boost::uint32_t, Timer *> TTimersMap;
+                
+                Timers(const Timers &);
+                Timers &operator=(const Timers &);
+                
+                inline boost::uint64_t tick(TClock::time_point now) const
+                {
+                    if (now < this->m_epoch)
+                    {
+                        return 0;
+                    }
+                    
+                    return std::chrono::duration_cast<std::chrono::milliseconds>(now - this->m_epoch).count();
+                }
+                
+                /**
+                 * Get an unused timer id. Ids wrap around, so the ids of long living timers (and 0, which is never a valid id) are skipped.
+                 */
+                inline boost::uint32_t allocateId()
+                {
+                    boost::uint32_t id;
+                    do
+                    {
+                        id = this->m_nextId++;
+                    }
+                    while (id == 0 || this->m_timers.find(id) != this->m_timers.end());
+                    
+                    return id;
+                }
+                
+                /* Cancel a timer that was already removed from the timers map */
+                inline void cancelTimer(Timer *timer)
+                {
+                    if (timer->isScheduled())
+                    {
+                        this->m_wheel.cancel(timer);
+                        this->release(timer);
+                    }
+                    else
+                    {
+                        /* Expired, but not called yet (see run) */
+                        timer->cancelled = true;
+                    }
+                }
+                
+                inline void release(Timer *timer)
+                {
+                    timer->context.Reset();
+                    timer->callback.Reset();
+                    for (TArgsList::iterator it = timer->args.begin(); it != timer->args.end(); ++it)
+                    {
+                        it->Reset();
+                    }
+                    
+                    delete timer;
+                }
+                
+                inline static void Schedule(const FunctionCallbackInfo<Value>& info, bool repeat)
+                {
+                    Timers *self = static_cast<Timers *>(External::Cast(*info.Data())->Value());
+                    
+                    if (info.Length() < 1 || !info[0]->IsFunction())
+                    {
+                        info.GetIsolate()->ThrowException(v8::Exception::TypeError(String::NewFromUtf8(info.GetIsolate(), "The timer callback must be a function.")));
+                        return;
+                    }
+                    
+                    double delay = info.Length() > 1 ? info[1]->NumberValue() : 0;
+                    if (!(delay > 0)) // also handles NaN
+                    {
+                        delay = 0;
+                    }
+                    else if (delay > 2147483647.0)
+                    {
+                        /* Like browsers, a delay that overflows a signed 32-bit integer (including Infinity) fires right away */
+                        delay = 1;
+                    }
+                    
+                    std::vector<Handle<Value> > args;
+                    for (int i = 2; i < info.Length(); ++i)
+                    {
+                        args.push_back(info[i]);
+                    }
+                    
+                    boost::uint32_t id = self->schedule(info.GetIsolate()->GetCurrentContext(), Handle<Function>::Cast(info[0]),
+                                                        static_cast<boost::uint64_t>(delay), repeat, args);
+                    
+                    info.GetReturnValue().Set(id);
+                }
+                
+                Isolate *m_isolationScope;
+                TClock::time_point m_epoch;
+                detail::TimingWheel m_wheel;
+                TTimersMap m_timers;
+                boost::uint32_t m_nextId;
+            };
+        }
+    }
+}
+
+#endif
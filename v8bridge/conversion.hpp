@@ -34,6 +34,9 @@
 /* Native values to JavaScript handles conversion */
 #include <v8bridge/conversion/native_to_js_conversion.hpp>
 
+/* External (non-copied) native strings */
+#include <v8bridge/conversion/external_string.hpp>
+
 /* Native values to string conversion */
 #include <v8bridge/conversion/native_to_string_conversion.hpp>
 
@@ -0,0 +1,223 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * This file declares ExternalString and ExternalString16, opt-in return types that hands a native
+ * string buffer over to V8 as an external string instead of copying it into the V8 heap.
+ *
+ * Example:
+ *      ExternalString render_template(std::string name)
+ *      {
+ *          std::string output = ...; // a large document
+ *          return ExternalString(std::move(output));
+ *      }
+ *
+ * The buffer is kept alive by a shared pointer, which is released when V8 collects the string.
+ */
+
+#ifndef v8bridge_external_string_hpp
+#define v8bridge_external_string_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+#include <v8bridge/conversion/native_to_js_conversion.hpp>
+
+#include <string>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+/* Strings shorter than this are copied anyway, since an external string costs
+    an extra native allocation and a V8 finalization entry. */
+#ifndef V8BRIDGE_EXTERNAL_STRING_MIN_LENGTH
+#   define V8BRIDGE_EXTERNAL_STRING_MIN_LENGTH 256
+#endif
+
+namespace v8
+{
+    namespace bridge
+    {
+        using namespace v8;
+        
+        /**
+         * A one-byte native string that should be exposed to JS as an external string.
+         *
+         * Note that V8 one-byte strings are Latin-1. Since std::string is treated as UTF-8 in the Conversion API,
+         * the buffer will be externalized only if it contains plain ASCII. Otherwise, it's copied (just like std::string).
+         */
+        class V8_DECL ExternalString
+        {
+        public:
+            typedef boost::shared_ptr<const std::string> TBuffer;
+            
+            /* Takes over the given string contents. */
+            explicit ExternalString(std::string &&value) : m_buffer(new std::string(std::move(value))) { }
+            
+            /* Shares the given buffer with V8. The buffer must not be modified afterwards. */
+            explicit ExternalString(TBuffer buffer) : m_buffer(buffer) { }
+            
+            inline const TBuffer &getBuffer() const { return this->m_buffer; }
+        private:
+            TBuffer m_buffer;
+        };
+        
+        /**
+         * A two-byte (UTF-16) native string that should be exposed to JS as an external string.
+         */
+        class V8_DECL ExternalString16
+        {
+        public:
+            typedef std::u16string TString;
+            typedef boost::shared_ptr<const TString> TBuffer;
+            
+            /* Takes over the given string contents. */
+            explicit ExternalString16(TString &&value) : m_buffer(new TString(std::move(value))) { }
+            
+            /* Shares the given buffer with V8. The buffer must not be modified afterwards. */
+            explicit ExternalString16(TBuffer buffer) : m_buffer(buffer) { }
+            
+            inline const TBuffer &getBuffer() const { return this->m_buffer; }
+        private:
+            TBuffer m_buffer;
+        };
+        
+        namespace detail
+        {
+#if V8BRIDGE_V8_VERSION_AT_LEAST(4, 3)
+            typedef String::ExternalOneByteStringResource TExternalOneByteResourceBase;
+#else
+            typedef String::ExternalAsciiStringResource TExternalOneByteResourceBase;
+#endif
+            
+            /**
+             * V8 external string resource that keeps the native buffer alive.
+             * V8 calls Dispose() (which deletes the resource) once the string was collected,
+             * and as a result the buffer reference is released.
+             */
+            template <class TBase, class TBuffer, class TChar>
+            class ExternalStringResource : public TBase
+            {
+            public:
+                ExternalStringResource(TBuffer buffer) : m_buffer(buffer) { }
+                
+                virtual const TChar *data() const { return reinterpret_cast<const TChar *>(this->m_buffer->data()); }
+                virtual size_t length() const { return this->m_buffer->size(); }
+            private:
+                TBuffer m_buffer;
+            };
+            
+            typedef ExternalStringResource<TExternalOneByteResourceBase, ExternalString::TBuffer, char> TExternalOneByteResource;
+            typedef ExternalStringResource<String::ExternalStringResource, ExternalString16::TBuffer, boost::uint16_t> TExternalTwoByteResource;
+            
+            inline bool is_ascii(const std::string &value)
+            {
+                const unsigned char *it = reinterpret_cast<const unsigned char *>(value.data());
+                const unsigned char *end = it + value.size();
+                
+                unsigned char mask = 0;
+                for (; it != end; ++it)
+                {
+                    mask |= *it;
+                }
+                
+                return (mask & 0x80) == 0;
+            }
+            
+            //-------------------------------------------------
+            //  Conversion
+            //-------------------------------------------------
+            
+            template<>
+            struct NativeToJsConversion<ExternalString>
+            {
+                inline v8::Handle<v8::Value> operator() (
+                                                         Isolate *isolationScope,
+                                                         const ExternalString& from)
+                {
+                    const ExternalString::TBuffer &buffer = from.getBuffer();
+                    if (!buffer)
+                    {
+                        return String::Empty(isolationScope);
+                    }
+                    
+                    if (buffer->size() < V8BRIDGE_EXTERNAL_STRING_MIN_LENGTH || !is_ascii(*buffer))
+                    {
+                        return String::NewFromUtf8(isolationScope, buffer->data(), String::kNormalString, (int)buffer->size());
+                    }
+                    
+                    TExternalOneByteResource *resource = new TExternalOneByteResource(buffer);
+#if V8BRIDGE_V8_VERSION_AT_LEAST(4, 3)
+                    Local<String> result;
+                    if (!String::NewExternalOneByte(isolationScope, resource).ToLocal(&result))
+                    {
+                        /* V8 did not take the ownership, fallback to copying the buffer */
+                        delete resource;
+                        return String::NewFromUtf8(isolationScope, buffer->data(), String::kNormalString, (int)buffer->size());
+                    }
+                    return result;
+#else
+                    return String::NewExternal(isolationScope, resource);
+#endif
+                }
+            };
+            
+            template<>
+            struct NativeToJsConversion<ExternalString16>
+            {
+                inline v8::Handle<v8::Value> operator() (
+                                                         Isolate *isolationScope,
+                                                         const ExternalString16& from)
+                {
+                    const ExternalString16::TBuffer &buffer = from.getBuffer();
+                    if (!buffer)
+                    {
+                        return String::Empty(isolationScope);
+                    }
+                    
+                    if (buffer->size() < V8BRIDGE_EXTERNAL_STRING_MIN_LENGTH)
+                    {
+                        return String::NewFromTwoByte(isolationScope, reinterpret_cast<const boost::uint16_t *>(buffer->data()), String::kNormalString, (int)buffer->size());
+                    }
+                    
+                    TExternalTwoByteResource *resource = new TExternalTwoByteResource(buffer);
+#if V8BRIDGE_V8_VERSION_AT_LEAST(4, 3)
+                    Local<String> result;
+                    if (!String::NewExternalTwoByte(isolationScope, resource).ToLocal(&result))
+                    {
+                        /* V8 did not take the ownership, fallback to copying the buffer */
+                        delete resource;
+                        return String::NewFromTwoByte(isolationScope, reinterpret_cast<const boost::uint16_t *>(buffer->data()), String::kNormalString, (int)buffer->size());
+                    }
+                    return result;
+#else
+                    return String::NewExternal(isolationScope, resource);
+#endif
+                }
+            };
+        }
+    }
+}
+
+#endif
@@ -32,13 +32,23 @@
 
 #include <v8bridge/conversion.hpp>
 #include <v8bridge/conversion/type_resolver.hpp>
+#include <v8bridge/detail/typed_array.hpp>
 #include <v8bridge/detail/typeid.hpp>
 #include <v8bridge/primitive.hpp>
+#include <limits>
 #include <list>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <stdlib.h>
 #include <stddef.h>
+#include <boost/cstdint.hpp>
+#include <boost/mpl/bool.hpp>
+#include <boost/mpl/if.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/is_signed.hpp>
 
 
 namespace v8
@@ -104,6 +114,96 @@ namespace v8
             //  Int combinations
             //-------------------------------------------------
 
+            /* Is the given value a Number holding an integer that can be represented losslessly */
+            inline bool is_safe_integer(Handle<Value> from, bool isSigned)
+            {
+                if (!from->IsNumber())
+                {
+                    return false;
+                }
+
+                double value = from->NumberValue();
+                return value <= kMaxSafeInteger
+                    && value >= (isSigned ? -kMaxSafeInteger : 0)
+                    && value == (double)(int64_t)value;
+            }
+
+            /* 8, 16 and 32 bits signed integers: accepts Int32 values within the target type range */
+            template <typename TIntType>
+            inline bool int_from_js(TIntType& to, Handle<Value> from, boost::mpl::false_ /* is 64 bits */, boost::true_type /* is signed */)
+            {
+                if (!from->IsInt32())
+                {
+                    return false;
+                }
+
+                int32_t value = from->Int32Value();
+                if (value < std::numeric_limits<TIntType>::min() || value > std::numeric_limits<TIntType>::max())
+                {
+                    return false;
+                }
+
+                to = (TIntType)value;
+                return true;
+            }
+
+            /* 8, 16 and 32 bits unsigned integers: accepts Uint32 values within the target type range */
+            template <typename TIntType>
+            inline bool int_from_js(TIntType& to, Handle<Value> from, boost::mpl::false_ /* is 64 bits */, boost::false_type /* is signed */)
+            {
+                if (!from->IsUint32())
+                {
+                    return false;
+                }
+
+                uint32_t value = from->Uint32Value();
+                if (value > std::numeric_limits<TIntType>::max())
+                {
+                    return false;
+                }
+
+                to = (TIntType)value;
+                return true;
+            }
+
+            /* 64 bits integers: accepts Int32, safe-range integral Numbers and BigInts that fit without truncation */
+            template <typename TIntType, typename TSigned>
+            inline bool int_from_js(TIntType& to, Handle<Value> from, boost::mpl::true_ /* is 64 bits */, TSigned isSigned)
+            {
+                if (from->IsInt32() && (TSigned::value || from->Int32Value() >= 0))
+                {
+                    to = from->Int32Value();
+                    return true;
+                }
+
+                if (is_safe_integer(from, TSigned::value))
+                {
+                    to = (TIntType)from->NumberValue();
+                    return true;
+                }
+
+#if V8BRIDGE_HAS_BIGINT
+                if (from->IsBigInt())
+                {
+                    bool lossless = false;
+                    Local<BigInt> bigint = Local<BigInt>::Cast(static_cast<Local<Value> >(from));
+
+                    if (TSigned::value)
+                    {
+                        to = (TIntType)bigint->Int64Value(&lossless);
+                    }
+                    else
+                    {
+                        to = (TIntType)bigint->Uint64Value(&lossless);
+                    }
+
+                    return lossless;
+                }
+#endif
+
+                return false;
+            }
+
             /* Generic conversion structure */
             template <typename TIntType>
             struct Int_JsToNativeConversion
@@ -113,19 +213,13 @@ namespace v8
                                        TIntType& to,
                                        v8::Handle<v8::Value> from)
                 {
-                    if (!from->IsInt32())
-                    {
-                        return false;
-                    }
-
-                    to = from->Int32Value();
-
-                    return true;
+                    return int_from_js(to, from, boost::mpl::bool_<(sizeof(TIntType) > 4)>(), boost::is_signed<TIntType>());
                 }
 
                 inline static bool isConvertable(Isolate *isolationScope, Handle<Value> from)
                 {
-                    return from->IsInt32();
+                    TIntType value;
+                    return int_from_js(value, from, boost::mpl::bool_<(sizeof(TIntType) > 4)>(), boost::is_signed<TIntType>());
                 }
             };
 
@@ -592,9 +686,49 @@ namespace v8
             //  Sequence
             //-------------------------------------------------
 
+            /* Copies BigInt64Array/BigUint64Array contents straight into a 64 bits integers vector */
+            template<typename TElemType, typename TType>
+            inline bool seq_from_typed_array(TType& to, v8::Handle<v8::Value> from, boost::mpl::false_)
+            {
+                return false;
+            }
+
+#if V8BRIDGE_HAS_BIGINT
+            template<typename TElemType>
+            inline bool seq_from_typed_array(std::vector<TElemType>& to, v8::Handle<v8::Value> from, boost::mpl::true_)
+            {
+                typedef typename boost::mpl::if_<boost::is_signed<TElemType>, boost::int64_t, boost::uint64_t>::type TElement;
+
+                if (!TypedArrayTraits<TElement>::is(from))
+                {
+                    return false;
+                }
+
+                v8::Local<v8::TypedArray> array = v8::Local<v8::TypedArray>::Cast(static_cast<v8::Local<v8::Value> >(from));
+                size_t offset = to.size();
+                to.resize(offset + array->Length());
+
+                if (array->Length() > 0)
+                {
+                    array->CopyContents(&to[offset], array->Length() * sizeof(TElement));
+                }
+
+                return true;
+            }
+#endif
+
             template<typename TType, typename TElemType>
             struct Seq_JsToNativeConversion
             {
+                /* Only vectors of 64 bits integers can be filled from a typed array */
+                typedef boost::mpl::bool_<
+                    V8BRIDGE_HAS_BIGINT
+                    && boost::is_same<TType, std::vector<TElemType> >::value
+                    && boost::is_integral<TElemType>::value
+                    && !boost::is_same<TElemType, bool>::value
+                    && sizeof(TElemType) == 8
+                > is_int64_vector;
+
                 inline bool operator()(
                                        Isolate *isolationScope,
                                        TType& to,
@@ -605,6 +739,11 @@ namespace v8
                         return true;
                     }
 
+                    if (seq_from_typed_array<TElemType>(to, from, is_int64_vector()))
+                    {
+                        return true;
+                    }
+
                     if (!from->IsArray())
                     {
                         return false;
@@ -624,7 +763,19 @@ namespace v8
 
                 inline static bool isConvertable(Isolate *isolationScope, Handle<Value> from)
                 {
-                    return from.IsEmpty() || from->IsArray();
+                    if (from.IsEmpty() || from->IsArray())
+                    {
+                        return true;
+                    }
+
+#if V8BRIDGE_HAS_BIGINT
+                    if (is_int64_vector::value)
+                    {
+                        return boost::is_signed<TElemType>::value ? from->IsBigInt64Array() : from->IsBigUint64Array();
+                    }
+#endif
+
+                    return false;
                 }
             };
 
@@ -635,17 +786,33 @@ namespace v8
             struct JsToNativeConversion<std::list<TType> > : public Seq_JsToNativeConversion<std::list<TType>, TType> { };
 
 
-#pragma region - std::map
+#pragma region - std::map & std::unordered_map
             //-------------------------------------------------
             //  Map
             //-------------------------------------------------
 
-            template<typename TKey, typename TValue>
-            struct JsToNativeConversion<std::map<TKey, TValue> >
+            /* Pre-size the destination map (a no-op for ordered maps) */
+            template<typename TMap>
+            inline void reserve_map(TMap &map, size_t count) { }
+
+            template<typename TKey, typename TValue, typename THash, typename TPred, typename TAlloc>
+            inline void reserve_map(std::unordered_map<TKey, TValue, THash, TPred, TAlloc> &map, size_t count)
+            {
+                map.reserve(map.size() + count);
+            }
+
+            /**
+             * Generic object-to-map conversion.
+             *
+             * Only the object own properties are converted (the prototype chain is not walked),
+             * since this conversion is used for plain dictionary objects.
+             */
+            template<typename TMap, typename TKey, typename TValue>
+            struct Map_JsToNativeConversion
             {
                 inline bool operator()(
                                        Isolate *isolationScope,
-                                       std::map<TKey, TValue>& to,
+                                       TMap& to,
                                        v8::Handle<v8::Value> from)
                 {
                     if (from.IsEmpty())
@@ -659,31 +826,51 @@ namespace v8
                     }
 
                     v8::Handle<v8::Object> obj = v8::Handle<v8::Object>::Cast(from);
-                    v8::Local<v8::Array> prop_names = obj->GetPropertyNames();
+                    v8::Local<v8::Array> prop_names = obj->GetOwnPropertyNames();
+                    const uint32_t length = prop_names->Length();
+
+                    reserve_map(to, length);
+
+                    JsToNativeConversion<TKey> keyConvertor;
+                    JsToNativeConversion<TValue> valueConvertor;
 
-                    for (uint32_t i = 0; i < prop_names->Length(); ++i)
+                    for (uint32_t i = 0; i < length; ++i)
                     {
                         v8::Local<v8::Value> js_name = prop_names->Get(i);
                         v8::Local<v8::Value> js_value = obj->Get(js_name);
 
+                        /* Index-like keys are reported as numbers, so we'll retry with their string form */
                         TKey key;
-                        JsToNativeConversion<TKey>()(key, js_name, isolationScope);
+                        if (!keyConvertor(isolationScope, key, js_name)
+                            && (js_name->IsString() || !keyConvertor(isolationScope, key, js_name->ToString())))
+                        {
+                            return false;
+                        }
 
                         TValue value;
-                        JsToNativeConversion<TValue>()(value, js_value, isolationScope);
+                        if (!valueConvertor(isolationScope, value, js_value))
+                        {
+                            return false;
+                        }
 
-                        typedef typename std::map<TKey, TValue>::value_type value_type;
-                        to.insert(value_type(key, value));
+                        typedef typename TMap::value_type value_type;
+                        to.insert(to.end(), value_type(key, value));
                     }
 
                     return true;
                 }
+
+                inline static bool isConvertable(Isolate *isolationScope, Handle<Value> from)
+                {
+                    return from.IsEmpty() || from->IsObject();
+                }
             };
 
-            inline static bool isConvertable(Isolate *isolationScope, Handle<Value> from)
-            {
-                return from.IsEmpty() || from->IsObject();
-            }
+            template<typename TKey, typename TValue>
+            struct JsToNativeConversion<std::map<TKey, TValue> > : public Map_JsToNativeConversion<std::map<TKey, TValue>, TKey, TValue> { };
+
+            template<typename TKey, typename TValue>
+            struct JsToNativeConversion<std::unordered_map<TKey, TValue> > : public Map_JsToNativeConversion<std::unordered_map<TKey, TValue>, TKey, TValue> { };
         }
 
         //-------------------------------------------------
@@ -31,7 +31,20 @@
 #include <v8bridge/detail/prefix.hpp>
 
 #include <exception>
+#include <list>
+#include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/mpl/bool.hpp>
+#include <boost/mpl/if.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/is_signed.hpp>
+
+#include <v8bridge/detail/typed_array.hpp>
 
 namespace v8
 {
@@ -88,6 +101,52 @@ namespace v8
             //  Integer types
             //-------------------------------------------------
             
+            /* 8, 16 and 32 bits signed integers */
+            template<typename TType>
+            inline v8::Handle<v8::Value> int_to_js(Isolate *isolationScope, TType from, boost::mpl::false_ /* is 64 bits */, boost::true_type /* is signed */)
+            {
+                return v8::Int32::New(isolationScope, (int32_t)from);
+            }
+            
+            /* 8, 16 and 32 bits unsigned integers */
+            template<typename TType>
+            inline v8::Handle<v8::Value> int_to_js(Isolate *isolationScope, TType from, boost::mpl::false_ /* is 64 bits */, boost::false_type /* is signed */)
+            {
+                return v8::Integer::NewFromUnsigned(isolationScope, (uint32_t)from);
+            }
+            
+            /* 64 bits signed integers: numbers within the safe range are passed as Number, the rest as BigInt */
+            template<typename TType>
+            inline v8::Handle<v8::Value> int_to_js(Isolate *isolationScope, TType from, boost::mpl::true_ /* is 64 bits */, boost::true_type /* is signed */)
+            {
+                if (from >= -(int64_t)kMaxSafeInteger && from <= (int64_t)kMaxSafeInteger)
+                {
+                    return v8::Number::New(isolationScope, (double)from);
+                }
+                
+#if V8BRIDGE_HAS_BIGINT
+                return v8::BigInt::New(isolationScope, (int64_t)from);
+#else
+                return v8::Number::New(isolationScope, (double)from);
+#endif
+            }
+            
+            /* 64 bits unsigned integers */
+            template<typename TType>
+            inline v8::Handle<v8::Value> int_to_js(Isolate *isolationScope, TType from, boost::mpl::true_ /* is 64 bits */, boost::false_type /* is signed */)
+            {
+                if (from <= (uint64_t)kMaxSafeInteger)
+                {
+                    return v8::Number::New(isolationScope, (double)from);
+                }
+                
+#if V8BRIDGE_HAS_BIGINT
+                return v8::BigInt::NewFromUnsigned(isolationScope, (uint64_t)from);
+#else
+                return v8::Number::New(isolationScope, (double)from);
+#endif
+            }
+            
             /* Declare int handler */
             template<typename TType>
             struct Int_NativeToJsConversion
@@ -96,7 +155,7 @@ namespace v8
                                                          Isolate *isolationScope,
                                                          TType from)
                 {
-                    return v8::Int32::New(isolationScope, (int)from);
+                    return int_to_js(isolationScope, from, boost::mpl::bool_<(sizeof(TType) > 4)>(), boost::is_signed<TType>());
                 }
             };
             
@@ -229,12 +288,32 @@ namespace v8
             //-------------------------------------------------
 #pragma region - std::vector<TType>
             
+            /* 64 bits integer vectors are passed as a plain Array of Numbers by default. Define V8BRIDGE_USE_BIGINT64_ARRAYS as 1
+                in order to pass them as BigInt64Array/BigUint64Array instead (note that their elements are BigInts, so mixing them with Numbers throws) */
+#ifndef V8BRIDGE_USE_BIGINT64_ARRAYS
+#   define V8BRIDGE_USE_BIGINT64_ARRAYS 0
+#endif
+            
+            template<typename TType>
+            struct is_int64_array_element : boost::mpl::bool_<
+                V8BRIDGE_HAS_BIGINT && V8BRIDGE_USE_BIGINT64_ARRAYS
+                && boost::is_integral<TType>::value
+                && !boost::is_same<TType, bool>::value
+                && sizeof(TType) == 8
+            > { };
+            
             template<typename TType>
             struct NativeToJsConversion<std::vector<TType> >
             {
                 inline v8::Handle<v8::Value> operator() (
                                                          Isolate *isolationScope,
                                                          const std::vector<TType>& from)
+                {
+                    return this->convert(isolationScope, from, is_int64_array_element<TType>());
+                }
+                
+            private:
+                inline v8::Handle<v8::Value> convert(Isolate *isolationScope, const std::vector<TType>& from, boost::mpl::false_)
                 {
                     using namespace v8;
                     
@@ -242,14 +321,28 @@ namespace v8
                     
                     typedef typename std::vector<TType>::const_iterator iterator_type;
                     
+                    NativeToJsConversion<TType> convertor;
+                    
                     int i = 0;
                     for (iterator_type it = from.begin(); it != from.end(); ++it)
                     {
-                        array->Set(i++, NativeToJsConversion<TType>()(*it, isolationScope));
+                        array->Set(i++, convertor(isolationScope, *it));
                     }
                     
                     return array;
                 }
+                
+#if V8BRIDGE_HAS_BIGINT
+                inline v8::Handle<v8::Value> convert(Isolate *isolationScope, const std::vector<TType>& from, boost::mpl::true_)
+                {
+                    /* Same representation as the typed array elements, so we can copy the vector as-is */
+                    typedef typename boost::mpl::if_<boost::is_signed<TType>, boost::int64_t, boost::uint64_t>::type TElement;
+                    
+                    return new_typed_array<TElement>(isolationScope,
+                                                     reinterpret_cast<const TElement *>(from.empty() ? NULL : &from[0]),
+                                                     from.size());
+                }
+#endif
             };
             
             //-------------------------------------------------
@@ -283,26 +376,26 @@ namespace v8
             //-------------------------------------------------
             //  Map
             //-------------------------------------------------
-#pragma region - std::map<TKey, TValue>
+#pragma region - std::map<TKey, TValue> & std::unordered_map<TKey, TValue>
             
-            template<typename TKey, typename TValue>
-            struct NativeToJsConversion<std::map<TKey, TValue> >
+            template<typename TMap, typename TKey, typename TValue>
+            struct Map_NativeToJsConversion
             {
                 inline v8::Handle<v8::Value> operator() (
                                                          Isolate *isolationScope,
-                                                         const std::map<TKey, TValue>& from)
+                                                         const TMap& from)
                 {
-                    using namespace v8;
+                    typedef typename TMap::const_iterator iterator_type;
                     
                     Handle<Object> object = Object::New(isolationScope);
                     
-                    typedef typename std::map<TKey, TValue>::const_iterator iterator_type;
-                    
+                    NativeToJsConversion<TKey> keyConvertor;
+                    NativeToJsConversion<TValue> valueConvertor;
                     for (iterator_type it = from.begin(); it != from.end(); ++it)
                     {
                         object->Set(
-                                    NativeToJsConversion<TKey>()(isolationScope, it->first),
-                                    NativeToJsConversion<TValue>()(isolationScope, it->second)
+                                    keyConvertor(isolationScope, it->first),
+                                    valueConvertor(isolationScope, it->second)
                                     );
                     }
                     
@@ -310,6 +403,12 @@ namespace v8
                 }
             };
             
+            template<typename TKey, typename TValue>
+            struct NativeToJsConversion<std::map<TKey, TValue> > : public Map_NativeToJsConversion<std::map<TKey, TValue>, TKey, TValue> { };
+            
+            template<typename TKey, typename TValue>
+            struct NativeToJsConversion<std::unordered_map<TKey, TValue> > : public Map_NativeToJsConversion<std::unordered_map<TKey, TValue>, TKey, TValue> { };
+            
             //-------------------------------------------------
             //  Null
             //-------------------------------------------------
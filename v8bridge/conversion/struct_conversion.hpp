@@ -0,0 +1,221 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * This file declares the V8BRIDGE_STRUCT descriptor macro, which connects plain C++ records
+ * with the Conversion API as plain JS objects.
+ *
+ * Example:
+ *      struct Point { double x; double y; double z; };
+ *      V8BRIDGE_STRUCT(Point, x, y, z)
+ *
+ *      Point midpoint(Point a, Point b);   // can now be exposed with NativeFunction
+ *
+ *  JS:
+ *      var p = midpoint({ x: 0, y: 0, z: 0 }, { x: 2, y: 2, z: 2 });
+ *      log(p.x + ", " + p.y + ", " + p.z);
+ *
+ * The generated conversions use the engine cached StructShape (internalized keys and an object template),
+ * so all the produced objects share one hidden class. Fields are read back in the declaration order.
+ *
+ * Note that V8BRIDGE_STRUCT should be used in the global namespace.
+ */
+
+#ifndef v8bridge_struct_conversion_hpp
+#define v8bridge_struct_conversion_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+#include <v8bridge/detail/struct_shape.hpp>
+#include <v8bridge/scripting_engine.hpp>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/preprocessor/stringize.hpp>
+#include <boost/preprocessor/seq/enum.hpp>
+#include <boost/preprocessor/seq/for_each_i.hpp>
+#include <boost/preprocessor/seq/transform.hpp>
+#include <boost/preprocessor/variadic/size.hpp>
+#include <boost/preprocessor/variadic/to_seq.hpp>
+
+namespace v8
+{
+    namespace bridge
+    {
+        namespace detail
+        {
+            /* Get the StructShape of the given struct in the given isolation scope */
+            template <class TStruct>
+            struct StructShapeScope
+            {
+                StructShapeScope(Isolate *isolationScope) : m_shape(NULL)
+                {
+                    ScriptingEngine *engine = ScriptingEngine::EngineFromIsolationScope(isolationScope);
+                    if (engine != NULL)
+                    {
+                        this->m_shape = engine->template getStructShape<TStruct>();
+                    }
+                    else
+                    {
+                        /* No engine to cache the shape in, so just use a temporary one */
+                        this->m_temporaryShape.reset(new StructShape(isolationScope,
+                                                                     StructDescriptor<TStruct>::fieldNames(),
+                                                                     StructDescriptor<TStruct>::fieldsCount));
+                        this->m_shape = this->m_temporaryShape.get();
+                    }
+                }
+                
+                inline StructShape *operator->() { return this->m_shape; }
+                inline StructShape *get() { return this->m_shape; }
+            private:
+                StructShape *m_shape;
+                boost::scoped_ptr<StructShape> m_temporaryShape;
+            };
+            
+            /* Field visitor: native field -> JS property */
+            struct StructFieldWriter
+            {
+                StructFieldWriter(Isolate *isolationScope, StructShape *shape, Handle<Object> object)
+                : m_isolationScope(isolationScope), m_shape(shape), m_object(object) { }
+                
+                template <class TField>
+                inline bool operator()(size_t index, const TField &field)
+                {
+                    this->m_object->Set(this->m_shape->getKey(index), NativeToJsConversion<TField>()(this->m_isolationScope, field));
+                    return true;
+                }
+            private:
+                Isolate *m_isolationScope;
+                StructShape *m_shape;
+                Handle<Object> m_object;
+            };
+            
+            /* Field visitor: JS property -> native field */
+            struct StructFieldReader
+            {
+                StructFieldReader(Isolate *isolationScope, StructShape *shape, Handle<Object> object)
+                : m_isolationScope(isolationScope), m_shape(shape), m_object(object) { }
+                
+                template <class TField>
+                inline bool operator()(size_t index, TField &field)
+                {
+                    return JsToNativeConversion<TField>()(this->m_isolationScope, field, this->m_object->Get(this->m_shape->getKey(index)));
+                }
+            private:
+                Isolate *m_isolationScope;
+                StructShape *m_shape;
+                Handle<Object> m_object;
+            };
+            
+            //-------------------------------------------------
+            //  Conversions
+            //-------------------------------------------------
+            
+            template <class TStruct>
+            struct Struct_NativeToJsConversion
+            {
+                inline v8::Handle<v8::Value> operator() (
+                                                         Isolate *isolationScope,
+                                                         const TStruct& from)
+                {
+                    EscapableHandleScope handle_scope(isolationScope);
+                    
+                    StructShapeScope<TStruct> shape(isolationScope);
+                    Local<Object> object = shape->newInstance();
+                    
+                    StructFieldWriter writer(isolationScope, shape.get(), object);
+                    StructDescriptor<TStruct>::visit(from, writer);
+                    
+                    return handle_scope.Escape(object);
+                }
+            };
+            
+            template <class TStruct>
+            struct Struct_JsToNativeConversion
+            {
+                inline bool operator()(
+                                       Isolate *isolationScope,
+                                       TStruct& to,
+                                       v8::Handle<v8::Value> from)
+                {
+                    if (from.IsEmpty() || !from->IsObject())
+                    {
+                        return false;
+                    }
+                    
+                    HandleScope handle_scope(isolationScope);
+                    
+                    StructShapeScope<TStruct> shape(isolationScope);
+                    StructFieldReader reader(isolationScope, shape.get(), Handle<Object>::Cast(from));
+                    
+                    return StructDescriptor<TStruct>::visit(to, reader);
+                }
+                
+                inline static bool isConvertable(Isolate *isolationScope, Handle<Value> from)
+                {
+                    return !from.IsEmpty() && from->IsObject();
+                }
+            };
+        }
+    }
+}
+
+//-------------------------------------------------
+//  Descriptor macro
+//-------------------------------------------------
+
+#define V8BRIDGE_STRUCT_FIELD_NAME(s, data, field)          BOOST_PP_STRINGIZE(field)
+#define V8BRIDGE_STRUCT_VISIT_FIELD(r, data, i, field)      visitor(i, value.field) &&
+
+#define V8BRIDGE_STRUCT(TStruct, ...) \
+    namespace v8 { namespace bridge { namespace detail { \
+        template <> \
+        struct StructDescriptor<TStruct> \
+        { \
+            enum { fieldsCount = BOOST_PP_VARIADIC_SIZE(__VA_ARGS__) }; \
+            \
+            inline static const char *const *fieldNames() \
+            { \
+                static const char *const names[] = { \
+                    BOOST_PP_SEQ_ENUM(BOOST_PP_SEQ_TRANSFORM(V8BRIDGE_STRUCT_FIELD_NAME, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))) \
+                }; \
+                return names; \
+            } \
+            \
+            template <class TValue, class TVisitor> \
+            inline static bool visit(TValue &value, TVisitor &visitor) \
+            { \
+                return BOOST_PP_SEQ_FOR_EACH_I(V8BRIDGE_STRUCT_VISIT_FIELD, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__)) true; \
+            } \
+        }; \
+        \
+        template <> \
+        struct NativeToJsConversion<TStruct> : public Struct_NativeToJsConversion<TStruct> { }; \
+        \
+        template <> \
+        struct JsToNativeConversion<TStruct> : public Struct_JsToNativeConversion<TStruct> { }; \
+    } } }
+
+#endif
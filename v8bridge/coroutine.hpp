@@ -0,0 +1,296 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * This file contains the C++20 coroutines support - awaiting JS promises (e.g. the result of async JS functions).
+ *
+ * ScriptingEngine::invokeAsync<TResult>(function, args...) invokes the given JS function and returns an awaitable.
+ * If the function returned a pending promise, the awaiting coroutine is suspended and resumed once the promise settles.
+ * The resolved value is converted to TResult by JsToNative, while a rejection is raised as an std::runtime_error.
+ *
+ * The promise reactions run when the engine microtasks are performed, and the coroutine is resumed by a task posted to the engine,
+ * so both are driven by the engine pump (see ScriptingEngine::runPending), on the engine thread.
+ *
+ * The awaiting state is shared by the awaiter and the promise reactions, so a reaction that is called after the awaiter
+ * was destroyed (e.g. when the awaiting coroutine was destroyed while suspended) is ignored.
+ *
+ * See samples/coroutines.cpp. Example (with any coroutine type, e.g. a fire-and-forget task):
+ *      task handle_request(ScriptingEngine &engine, UserlandFunction &fetchUser, int id)
+ *      {
+ *          std::string name = co_await engine.invokeAsync<std::string>(fetchUser, id);
+ *          ...
+ *      }
+ */
+
+#ifndef v8bridge_coroutine_hpp
+#define v8bridge_coroutine_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+/* Coroutines rely on the C++20 compiler support and on the promises API of V8 6.6 or later
+    (Promise::State, Promise::Then with a rejection handler and the isolate aware String::Utf8Value) */
+#ifndef V8BRIDGE_HAS_COROUTINES
+#   if defined(__cpp_impl_coroutine) && V8BRIDGE_V8_VERSION_AT_LEAST(6, 6)
+#       define V8BRIDGE_HAS_COROUTINES 1
+#   else
+#       define V8BRIDGE_HAS_COROUTINES 0
+#   endif
+#endif
+
+#if V8BRIDGE_HAS_COROUTINES
+
+#include <coroutine>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <v8bridge/conversion.hpp>
+#include <v8bridge/detail/typeid.hpp>
+
+namespace v8
+{
+    namespace bridge
+    {
+        namespace detail
+        {
+            /* Holds the converted settled value */
+            template <class TResult>
+            struct AwaitedValue
+            {
+                inline bool from(Isolate *isolate, Local<Value> value)
+                {
+                    return JsToNative(isolate, this->value, value);
+                }
+                
+                inline TResult get() { return this->value; }
+                
+                TResult value;
+            };
+            
+            template <>
+            struct AwaitedValue<void>
+            {
+                inline bool from(Isolate *, Local<Value>) { return true; }
+                inline void get() { }
+            };
+            
+            /**
+             * Awaitable over a JS value, which may be a promise. See ScriptingEngine::invokeAsync.
+             */
+            template <class TResult, class TEngine>
+            class PromiseAwaiter
+            {
+            public:
+                PromiseAwaiter(TEngine *engine, Isolate *isolate, Local<Value> value) : m_state(std::make_shared<State>(engine, isolate))
+                {
+                    this->m_state->value.Reset(isolate, value);
+                }
+                
+                /* The call raised an exception (the returned awaiter rejects) */
+                PromiseAwaiter(TEngine *engine, Isolate *isolate, const std::string &error) : m_state(std::make_shared<State>(engine, isolate))
+                {
+                    this->m_state->reject(error);
+                }
+                
+                ~PromiseAwaiter()
+                {
+                    if (this->m_state)
+                    {
+                        /* A pending reaction should no longer resume the (possibly destroyed) continuation */
+                        this->m_state->value.Reset();
+                        this->m_state->continuation = nullptr;
+                    }
+                }
+                
+                PromiseAwaiter(PromiseAwaiter &&) = default;
+                
+                inline bool await_ready()
+                {
+                    State *state = this->m_state.get();
+                    if (state->settled)
+                    {
+                        return true;
+                    }
+                    
+                    HandleScope handle_scope(state->isolate);
+                    Local<Value> value = Local<Value>::New(state->isolate, state->value);
+                    
+                    /* Not a promise - settle immediately with the value */
+                    if (!value->IsPromise())
+                    {
+                        state->settle(value, false);
+                        return true;
+                    }
+                    
+                    /* Already settled promise */
+                    Local<Promise> promise = value.As<Promise>();
+                    if (promise->State() != Promise::kPending)
+                    {
+                        state->settle(promise->Result(), promise->State() == Promise::kRejected);
+                        return true;
+                    }
+                    
+                    return false;
+                }
+                
+                inline void await_suspend(std::coroutine_handle<> continuation)
+                {
+                    State *state = this->m_state.get();
+                    state->continuation = continuation;
+                    
+                    HandleScope handle_scope(state->isolate);
+                    Local<Context> context = state->isolate->GetCurrentContext();
+                    Local<Promise> promise = Local<Value>::New(state->isolate, state->value).As<Promise>();
+                    
+                    /* The reactions share the state with the awaiter (only one of them is ever called).
+                        The reaction data is released once both reactions are garbage collected. */
+                    Reaction *reaction = new Reaction(this->m_state);
+                    Local<External> data = External::New(state->isolate, reaction);
+                    reaction->handle.Reset(state->isolate, data);
+                    reaction->handle.SetWeak(reaction, &PromiseAwaiter::OnReactionCollected, WeakCallbackType::kParameter);
+                    
+                    promise->Then(context,
+                                  Function::New(context, &PromiseAwaiter::OnFulfilled, data).ToLocalChecked(),
+                                  Function::New(context, &PromiseAwaiter::OnRejected, data).ToLocalChecked());
+                }
+                
+                inline TResult await_resume()
+                {
+                    if (this->m_state->rejected)
+                    {
+                        throw std::runtime_error(this->m_state->error);
+                    }
+                    
+                    return this->m_state->result.get();
+                }
+            private:
+                struct State
+                {
+                    State(TEngine *engine, Isolate *isolate) : engine(engine), isolate(isolate), settled(false), rejected(false) { }
+                    
+                    ~State()
+                    {
+                        this->value.Reset();
+                    }
+                    
+                    inline void settle(Local<Value> value, bool isRejection)
+                    {
+                        if (isRejection)
+                        {
+                            String::Utf8Value message(this->isolate, value);
+                            this->reject(*message ? *message : "<string conversion failed>");
+                            return;
+                        }
+                        
+                        this->settled = true;
+                        if (!this->result.from(this->isolate, value))
+                        {
+                            this->rejected = true;
+                            this->error = "The awaited value does not match the specified TResult (" + TypeId<TResult>().name() + ").";
+                        }
+                    }
+                    
+                    inline void reject(const std::string &message)
+                    {
+                        this->settled = true;
+                        this->rejected = true;
+                        this->error = message;
+                    }
+                    
+                    TEngine *engine;
+                    Isolate *isolate;
+                    Persistent<Value> value;
+                    bool settled;
+                    bool rejected;
+                    std::string error;
+                    AwaitedValue<TResult> result;
+                    std::coroutine_handle<> continuation;
+                };
+                
+                /* The promise reactions data */
+                struct Reaction
+                {
+                    Reaction(const std::shared_ptr<State> &state) : state(state) { }
+                    
+                    std::shared_ptr<State> state;
+                    Persistent<External> handle; // Weak
+                };
+                
+                /* Posted to the engine, so the coroutine is resumed by the engine pump rather than inside the promise reaction */
+                struct ResumeTask
+                {
+                    inline void operator()(TEngine &)
+                    {
+                        /* The awaiter may have been destroyed since the task was posted */
+                        if (this->state->continuation)
+                        {
+                            this->state->continuation.resume();
+                        }
+                    }
+                    
+                    std::shared_ptr<State> state;
+                };
+                
+                inline static void OnSettled(const FunctionCallbackInfo<Value>& info, bool isRejection)
+                {
+                    Reaction *reaction = static_cast<Reaction *>(External::Cast(*info.Data())->Value());
+                    std::shared_ptr<State> state = reaction->state;
+                    reaction->state.reset();
+                    
+                    /* The awaiter was destroyed (or the other reaction was already called) */
+                    if (!state || !state->continuation)
+                    {
+                        return;
+                    }
+                    
+                    HandleScope handle_scope(state->isolate);
+                    state->settle(info[0], isRejection);
+                    state->value.Reset();
+                    
+                    ResumeTask task = { state };
+                    state->engine->post(task);
+                }
+                
+                inline static void OnReactionCollected(const WeakCallbackInfo<Reaction>& info)
+                {
+                    Reaction *reaction = info.GetParameter();
+                    reaction->handle.Reset();
+                    delete reaction;
+                }
+                
+                inline static void OnFulfilled(const FunctionCallbackInfo<Value>& info) { OnSettled(info, false); }
+                inline static void OnRejected(const FunctionCallbackInfo<Value>& info) { OnSettled(info, true); }
+                
+                std::shared_ptr<State> m_state;
+            };
+        }
+    }
+}
+
+#endif // V8BRIDGE_HAS_COROUTINES
+
+#endif
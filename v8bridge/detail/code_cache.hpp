@@ -0,0 +1,387 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * This file contains the persistent (on-disk) V8 code cache.
+ *
+ * Each compiled script gets a cache file in the cache directory, named after the script source hash
+ * and the V8 cached data version tag (which covers both the V8 version and the V8 flags).
+ * The file holds a copy of the source as well, so an entry is used only by the exact same source (and never on a hash collision).
+ * The cached data is read through mmap and handed to V8 as is. Rejected entries (e.g. after a V8 upgrade,
+ * a flags change or a corrupted file) are rebuilt transparently.
+ *
+ * Code caching requires V8 6.0 or later (ScriptCompiler::CreateCodeCache). On older versions the code cache
+ * is a no-op and the scripts are always compiled from source.
+ */
+
+#ifndef v8bridge_code_cache_hpp
+#define v8bridge_code_cache_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <stdio.h>
+#include <string.h>
+#include <sstream>
+#include <string>
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+
+#if defined(_WIN32)
+#   include <fstream>
+#   include <vector>
+#   include <direct.h>
+#   include <process.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <sys/types.h>
+#   include <unistd.h>
+#endif
+
+#ifndef V8BRIDGE_HAS_CODE_CACHE
+#   define V8BRIDGE_HAS_CODE_CACHE V8BRIDGE_V8_VERSION_AT_LEAST(6, 0)
+#endif
+
+namespace v8
+{
+    namespace bridge
+    {
+        /**
+         * Persistent code cache statistics (see ScriptingEngine::getCodeCacheStats).
+         */
+        struct CodeCacheStats
+        {
+            size_t hits;        // Scripts compiled from cached data
+            size_t misses;      // Scripts with no (valid) cache file
+            size_t rejections;  // Cache files rejected by V8 (and rebuilt)
+            size_t writes;      // Cache files written
+        };
+        
+        namespace detail
+        {
+            /* 64 bits FNV-1a hash */
+            inline boost::uint64_t fnv1a_hash(const char *data, size_t length, boost::uint64_t hash = 14695981039346656037ULL)
+            {
+                for (size_t i = 0; i < length; ++i)
+                {
+                    hash ^= (unsigned char)data[i];
+                    hash *= 1099511628211ULL;
+                }
+                
+                return hash;
+            }
+            
+            /* A process wide sequence, used to name temporary files uniquely across threads and engines */
+            inline boost::uint64_t next_temporary_file_id()
+            {
+                static boost::atomic<boost::uint64_t> sequence(0);
+                return sequence.fetch_add(1, boost::memory_order_relaxed);
+            }
+            
+            /**
+             * Compile the given source into a context independent script.
+             * Returns an empty handle if the compilation failed (the error is left in the active TryCatch).
+             */
+            inline Local<UnboundScript> compile_unbound_script(Isolate *isolationScope, const std::string &scriptCode, const std::string &fileName)
+            {
+#if V8BRIDGE_V8_VERSION_AT_LEAST(5, 0)
+                Local<String> code = String::NewFromUtf8(isolationScope, scriptCode.c_str(), NewStringType::kNormal, (int)scriptCode.size()).ToLocalChecked();
+                Local<String> name = String::NewFromUtf8(isolationScope, fileName.c_str(), NewStringType::kNormal, (int)fileName.size()).ToLocalChecked();
+#else
+                Local<String> code = String::NewFromUtf8(isolationScope, scriptCode.c_str(), String::kNormalString, (int)scriptCode.size());
+                Local<String> name = String::NewFromUtf8(isolationScope, fileName.c_str(), String::kNormalString, (int)fileName.size());
+#endif
+                
+#if V8BRIDGE_V8_VERSION_AT_LEAST(9, 0)
+                ScriptOrigin origin(isolationScope, name);
+#else
+                ScriptOrigin origin(name);
+#endif
+                ScriptCompiler::Source source(code, origin);
+                
+#if V8BRIDGE_V8_VERSION_AT_LEAST(5, 0)
+                Local<UnboundScript> script;
+                if (!ScriptCompiler::CompileUnboundScript(isolationScope, &source).ToLocal(&script))
+                {
+                    return Local<UnboundScript>();
+                }
+                return script;
+#else
+                return ScriptCompiler::CompileUnbound(isolationScope, &source);
+#endif
+            }
+            
+            /**
+             * A read-only view of a cache file contents (mapped into memory when possible).
+             */
+            class V8_DECL MappedFile
+            {
+            public:
+                MappedFile(const std::string &path) : m_data(NULL), m_length(0)
+                {
+#if defined(_WIN32)
+                    std::ifstream stream(path.c_str(), std::ios::in | std::ios::binary);
+                    if (stream)
+                    {
+                        this->m_buffer.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+                        this->m_data = this->m_buffer.empty() ? NULL : &this->m_buffer[0];
+                        this->m_length = this->m_buffer.size();
+                    }
+#else
+                    int fd = open(path.c_str(), O_RDONLY);
+                    if (fd < 0)
+                    {
+                        return;
+                    }
+                    
+                    struct stat info;
+                    if (fstat(fd, &info) == 0 && info.st_size > 0)
+                    {
+                        void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                        if (data != MAP_FAILED)
+                        {
+                            this->m_data = static_cast<const char *>(data);
+                            this->m_length = (size_t)info.st_size;
+                        }
+                    }
+                    
+                    close(fd);
+#endif
+                }
+                
+                ~MappedFile()
+                {
+#if !defined(_WIN32)
+                    if (this->m_data != NULL)
+                    {
+                        munmap(const_cast<char *>(this->m_data), this->m_length);
+                    }
+#endif
+                }
+                
+                inline const char *data() const { return this->m_data; }
+                inline size_t length() const { return this->m_length; }
+            private:
+                MappedFile(const MappedFile &);
+                MappedFile &operator=(const MappedFile &);
+                
+                const char *m_data;
+                size_t m_length;
+#if defined(_WIN32)
+                std::vector<char> m_buffer;
+#endif
+            };
+            
+            class V8_DECL CodeCache
+            {
+            public:
+                CodeCache(Isolate *isolationScope, const std::string &directory)
+                : m_isolationScope(isolationScope), m_directory(directory)
+                {
+                    memset(&this->m_stats, 0, sizeof(this->m_stats));
+                    
+                    if (!this->m_directory.empty() && this->m_directory[this->m_directory.size() - 1] != '/')
+                    {
+                        this->m_directory += '/';
+                    }
+                    
+#if defined(_WIN32)
+                    _mkdir(this->m_directory.c_str());
+#else
+                    mkdir(this->m_directory.c_str(), 0755);
+#endif
+                }
+                
+                /**
+                 * Compile the given source, using (or creating) its cache file.
+                 * Returns an empty handle if the compilation failed (the error is left in the active TryCatch).
+                 */
+                inline Local<UnboundScript> compile(const std::string &scriptCode, const std::string &fileName)
+                {
+#if V8BRIDGE_HAS_CODE_CACHE
+                    boost::uint64_t hash = fnv1a_hash(fileName.data(), fileName.size(), fnv1a_hash(scriptCode.data(), scriptCode.size()));
+                    std::string path = this->getPath(hash);
+                    
+                    //-------------------------------------------------
+                    //  Try to compile from the cache file
+                    //-------------------------------------------------
+                    
+                    {
+                        MappedFile file(path);
+                        const Header *header = reinterpret_cast<const Header *>(file.data());
+                        
+                        if (file.length() > sizeof(Header) + scriptCode.size()
+                            && header->magic == kMagic
+                            && header->versionTag == ScriptCompiler::CachedDataVersionTag()
+                            && header->sourceHash == hash
+                            && header->sourceLength == scriptCode.size()
+                            && header->dataLength == file.length() - sizeof(Header) - header->sourceLength
+                            && memcmp(file.data() + sizeof(Header), scriptCode.data(), scriptCode.size()) == 0)
+                        {
+                            ScriptCompiler::CachedData *cachedData = new ScriptCompiler::CachedData(
+                                                                                                   reinterpret_cast<const uint8_t *>(file.data() + sizeof(Header) + header->sourceLength),
+                                                                                                   (int)header->dataLength,
+                                                                                                   ScriptCompiler::CachedData::BufferNotOwned);
+                            
+                            /* The source takes the ownership of the cached data */
+                            ScriptCompiler::Source source(this->newString(scriptCode), this->newOrigin(fileName), cachedData);
+                            
+                            Local<UnboundScript> script;
+                            if (!ScriptCompiler::CompileUnboundScript(this->m_isolationScope, &source, ScriptCompiler::kConsumeCodeCache).ToLocal(&script))
+                            {
+                                return script;
+                            }
+                            
+                            if (!source.GetCachedData()->rejected)
+                            {
+                                ++this->m_stats.hits;
+                                return script;
+                            }
+                            
+                            ++this->m_stats.rejections;
+                        }
+                        else
+                        {
+                            ++this->m_stats.misses;
+                        }
+                    }
+                    
+                    //-------------------------------------------------
+                    //  (Re)build the cache file
+                    //-------------------------------------------------
+                    
+                    Local<UnboundScript> script = compile_unbound_script(this->m_isolationScope, scriptCode, fileName);
+                    if (script.IsEmpty())
+                    {
+                        return script;
+                    }
+                    
+                    ScriptCompiler::CachedData *cachedData = ScriptCompiler::CreateCodeCache(script);
+                    if (cachedData != NULL)
+                    {
+                        this->write(path, hash, scriptCode, cachedData);
+                        delete cachedData;
+                    }
+                    
+                    return script;
+#else
+                    ++this->m_stats.misses;
+                    return compile_unbound_script(this->m_isolationScope, scriptCode, fileName);
+#endif
+                }
+                
+                inline const std::string &getDirectory() const { return this->m_directory; }
+                inline CodeCacheStats getStats() const { return this->m_stats; }
+            private:
+                /* The cache file header. The source and the cached data follow it. */
+                struct Header
+                {
+                    boost::uint32_t magic;
+                    boost::uint32_t versionTag;
+                    boost::uint64_t sourceHash;
+                    boost::uint64_t sourceLength;
+                    boost::uint64_t dataLength;
+                };
+                
+                enum { kMagic = 0x32423856 }; // "V8B2"
+                
+                Isolate *m_isolationScope;
+                std::string m_directory;
+                CodeCacheStats m_stats;
+                
+#if V8BRIDGE_HAS_CODE_CACHE
+                inline std::string getPath(boost::uint64_t hash) const
+                {
+                    std::stringstream io;
+                    io << this->m_directory << std::hex << hash << "-" << ScriptCompiler::CachedDataVersionTag() << ".v8cache";
+                    return io.str();
+                }
+                
+                inline Local<String> newString(const std::string &value) const
+                {
+                    return String::NewFromUtf8(this->m_isolationScope, value.c_str(), NewStringType::kNormal, (int)value.size()).ToLocalChecked();
+                }
+                
+                inline ScriptOrigin newOrigin(const std::string &fileName) const
+                {
+#if V8BRIDGE_V8_VERSION_AT_LEAST(9, 0)
+                    return ScriptOrigin(this->m_isolationScope, this->newString(fileName));
+#else
+                    return ScriptOrigin(this->newString(fileName));
+#endif
+                }
+                
+                /* Write the cache file atomically (write a temporary file and rename it), so concurrent
+                    writers (processes, or engines of the same process) never observe a partially written entry */
+                inline void write(const std::string &path, boost::uint64_t hash, const std::string &scriptCode, const ScriptCompiler::CachedData *cachedData)
+                {
+                    std::stringstream io;
+#if defined(_WIN32)
+                    io << path << ".tmp." << _getpid() << "." << next_temporary_file_id();
+#else
+                    io << path << ".tmp." << getpid() << "." << next_temporary_file_id();
+#endif
+                    std::string temporaryPath = io.str();
+                    
+                    FILE *file = fopen(temporaryPath.c_str(), "wb");
+                    if (file == NULL)
+                    {
+                        return;
+                    }
+                    
+                    Header header;
+                    header.magic = kMagic;
+                    header.versionTag = ScriptCompiler::CachedDataVersionTag();
+                    header.sourceHash = hash;
+                    header.sourceLength = scriptCode.size();
+                    header.dataLength = (boost::uint64_t)cachedData->length;
+                    
+                    bool succeeded = fwrite(&header, sizeof(Header), 1, file) == 1
+                        && fwrite(scriptCode.data(), 1, scriptCode.size(), file) == scriptCode.size()
+                        && fwrite(cachedData->data, 1, (size_t)cachedData->length, file) == (size_t)cachedData->length;
+                    succeeded = (fclose(file) == 0) && succeeded;
+                    
+#if defined(_WIN32)
+                    /* rename() does not replace existing files on windows */
+                    remove(path.c_str());
+#endif
+                    if (!succeeded || rename(temporaryPath.c_str(), path.c_str()) != 0)
+                    {
+                        remove(temporaryPath.c_str());
+                        return;
+                    }
+                    
+                    ++this->m_stats.writes;
+                }
+#endif
+            };
+        }
+    }
+}
+
+#endif
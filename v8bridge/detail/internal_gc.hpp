@@ -118,12 +118,12 @@ namespace v8
             /**
              * Removes the given object from the GC cleanup instances list.
              */
-            inline void disposeAndDequeue(void *object)
+            inline bool disposeAndDequeue(void *object)
             {
                 TCleanupMap::iterator pair = this->m_map->find(object);
                 if (pair == this->m_map->end())
                 {
-                    return;
+                    return false;
                 }
                 
                 if (pair->second != NULL)
@@ -132,6 +132,15 @@ namespace v8
                 }
                 
                 this->m_map->erase(object);
+                return true;
+            }
+            
+            /**
+             * Get the number of instances in the GC cleanup list.
+             */
+            inline size_t size() const
+            {
+                return this->m_map->size();
             }
             
             /**
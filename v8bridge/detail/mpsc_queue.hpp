@@ -0,0 +1,126 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef v8bridge_mpsc_queue_hpp
+#define v8bridge_mpsc_queue_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <boost/atomic.hpp>
+
+namespace v8
+{
+    namespace bridge
+    {
+        namespace detail
+        {
+            /**
+             * Unbounded lock-free multi-producers single-consumer queue (D. Vyukov's node based MPSC queue).
+             *
+             * push may be called by any thread, while pop should only be called by a single (consumer) thread.
+             * Pushing never blocks and costs a single atomic exchange.
+             */
+            template <class TValue>
+            class MPSCQueue
+            {
+            public:
+                MPSCQueue() : m_head(new Node()), m_pendingCount(0)
+                {
+                    this->m_tail = this->m_head.load(boost::memory_order_relaxed);
+                }
+                
+                ~MPSCQueue()
+                {
+                    TValue value;
+                    while (this->pop(value)) { }
+                    
+                    delete this->m_tail;
+                }
+                
+                inline void push(const TValue &value)
+                {
+                    Node *node = new Node(value);
+                    this->m_pendingCount.fetch_add(1, boost::memory_order_relaxed);
+                    
+                    Node *previous = this->m_head.exchange(node, boost::memory_order_acq_rel);
+                    previous->next.store(node, boost::memory_order_release);
+                }
+                
+                /**
+                 * Pop the oldest value. Returns false if the queue is empty (or if a concurrent push was not completed yet).
+                 */
+                inline bool pop(TValue &value)
+                {
+                    Node *tail = this->m_tail;
+                    Node *next = tail->next.load(boost::memory_order_acquire);
+                    if (next == NULL)
+                    {
+                        return false;
+                    }
+                    
+                    /* The next node becomes the new stub node */
+                    value = next->value;
+                    next->value = TValue();
+                    
+                    this->m_tail = next;
+                    delete tail;
+                    
+                    this->m_pendingCount.fetch_sub(1, boost::memory_order_relaxed);
+                    return true;
+                }
+                
+                /**
+                 * The approximate number of pending values.
+                 */
+                inline size_t size() const
+                {
+                    return this->m_pendingCount.load(boost::memory_order_relaxed);
+                }
+                
+                inline bool empty() const { return this->size() == 0; }
+            private:
+                struct Node
+                {
+                    Node() : next(NULL) { }
+                    Node(const TValue &value) : next(NULL), value(value) { }
+                    
+                    boost::atomic<Node *> next;
+                    TValue value;
+                };
+                
+                MPSCQueue(const MPSCQueue &);
+                MPSCQueue &operator=(const MPSCQueue &);
+                
+                boost::atomic<Node *> m_head; // producers end
+                Node *m_tail;                 // consumer end (stub node)
+                boost::atomic<size_t> m_pendingCount;
+            };
+        }
+    }
+}
+
+#endif
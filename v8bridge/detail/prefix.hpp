@@ -37,6 +37,28 @@
 #   include <boost/config.hpp>
 #   include <v8bridge/config.hpp>
 
+/* V8 API availability checks.
+    V8_MAJOR_VERSION is only exported by v8-version.h (V8 4.3+), so older engines are treated as "0.0". */
+#   if defined(V8_MAJOR_VERSION) && defined(V8_MINOR_VERSION)
+#       define V8BRIDGE_V8_VERSION_AT_LEAST(major, minor) \
+                                                    ((V8_MAJOR_VERSION > (major)) \
+                                                    || (V8_MAJOR_VERSION == (major) && V8_MINOR_VERSION >= (minor)))
+#   else
+#       define V8BRIDGE_V8_VERSION_AT_LEAST(major, minor) 0
+#   endif
+
+/* Declare a TryCatch block. TryCatch(Isolate *) is available since V8 4.4, and the isolate-less constructor was removed in V8 6.x */
+#   if V8BRIDGE_V8_VERSION_AT_LEAST(4, 4)
+#       define V8BRIDGE_TRY_CATCH(name, isolate) v8::TryCatch name(isolate)
+#   else
+#       define V8BRIDGE_TRY_CATCH(name, isolate) v8::TryCatch name
+#   endif
+
+/* BigInt (and BigInt64Array/BigUint64Array) are available since V8 6.7 */
+#   ifndef V8BRIDGE_HAS_BIGINT
+#       define V8BRIDGE_HAS_BIGINT              V8BRIDGE_V8_VERSION_AT_LEAST(6, 7)
+#   endif
+
 #   ifdef __MWERKS__
 #       pragma warn_possunwant off
 #   elif _MSC_VER
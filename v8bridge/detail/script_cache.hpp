@@ -0,0 +1,252 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef v8bridge_script_cache_hpp
+#define v8bridge_script_cache_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <list>
+#include <string>
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <v8bridge/detail/code_cache.hpp>
+
+/* The default compiled scripts cache budget, in bytes of cached source code (0 = disabled) */
+#ifndef V8BRIDGE_SCRIPT_CACHE_BUDGET
+#   define V8BRIDGE_SCRIPT_CACHE_BUDGET (4 * 1024 * 1024)
+#endif
+
+namespace v8
+{
+    namespace bridge
+    {
+        /**
+         * Compiled scripts cache statistics (see ScriptingEngine::getScriptCacheStats).
+         */
+        struct ScriptCacheStats
+        {
+            size_t hits;
+            size_t misses;
+            size_t evictions;
+            size_t entries;
+            size_t bytes;
+            size_t budget;
+        };
+        
+        namespace detail
+        {
+            /**
+             * LRU cache of compiled (unbound) scripts, keyed by their source code and file name.
+             *
+             * The entries are located by the source hash, but the source itself is compared on lookup,
+             * so an hash collision can only result in a miss. The budget is measured in bytes of cached
+             * source code, which is what we can account for without inspecting the V8 heap.
+             */
+            class V8_DECL ScriptCache
+            {
+            public:
+                ScriptCache(Isolate *isolationScope, size_t budget = V8BRIDGE_SCRIPT_CACHE_BUDGET)
+                : m_isolationScope(isolationScope), m_codeCache(NULL), m_budget(budget), m_bytes(0), m_hits(0), m_misses(0), m_evictions(0)
+                {
+                    
+                }
+                
+                ~ScriptCache()
+                {
+                    this->clear();
+                    delete this->m_codeCache;
+                }
+                
+                /**
+                 * Use the given directory as a persistent code cache for the compiled scripts (see CodeCache).
+                 * An empty directory disables the persistent code cache.
+                 */
+                inline void setCodeCacheDirectory(const std::string &directory)
+                {
+                    delete this->m_codeCache;
+                    this->m_codeCache = directory.empty() ? NULL : new CodeCache(this->m_isolationScope, directory);
+                }
+                
+                inline CodeCache *getCodeCache() const { return this->m_codeCache; }
+                
+                /**
+                 * Get the compiled script of the given source, compiling (and caching) it if needed.
+                 * Returns an empty handle if the compilation failed.
+                 */
+                inline Local<UnboundScript> compile(const std::string &scriptCode, const std::string &fileName)
+                {
+                    if (this->m_budget == 0)
+                    {
+                        ++this->m_misses;
+                        return this->compileScript(scriptCode, fileName);
+                    }
+                    
+                    boost::uint64_t hash = fnv1a_hash(fileName.data(), fileName.size(), fnv1a_hash(scriptCode.data(), scriptCode.size()));
+                    
+                    //-------------------------------------------------
+                    //  Hit?
+                    //-------------------------------------------------
+                    
+                    TEntriesIndex::iterator it = this->m_index.find(hash);
+                    if (it != this->m_index.end())
+                    {
+                        TEntriesList::iterator entry = it->second;
+                        if (entry->scriptCode == scriptCode && entry->fileName == fileName)
+                        {
+                            ++this->m_hits;
+                            
+                            /* Mark as the most recently used */
+                            this->m_entries.splice(this->m_entries.begin(), this->m_entries, entry);
+                            return Local<UnboundScript>::New(this->m_isolationScope, entry->script);
+                        }
+                        
+                        /* Hash collision - the new script will replace the old one */
+                        this->erase(entry);
+                    }
+                    
+                    //-------------------------------------------------
+                    //  Miss
+                    //-------------------------------------------------
+                    
+                    ++this->m_misses;
+                    
+                    Local<UnboundScript> script = this->compileScript(scriptCode, fileName);
+                    size_t size = this->entrySize(scriptCode, fileName);
+                    
+                    if (script.IsEmpty() || size > this->m_budget)
+                    {
+                        return script;
+                    }
+                    
+                    this->m_entries.push_front(Entry());
+                    Entry &entry = this->m_entries.front();
+                    entry.hash = hash;
+                    entry.scriptCode = scriptCode;
+                    entry.fileName = fileName;
+                    entry.script.Reset(this->m_isolationScope, script);
+                    
+                    this->m_index[hash] = this->m_entries.begin();
+                    this->m_bytes += size;
+                    
+                    this->trim();
+                    
+                    return script;
+                }
+                
+                /**
+                 * Set the cache budget (in bytes of cached source code). Setting the budget to 0 disables the cache.
+                 */
+                inline void setBudget(size_t budget)
+                {
+                    this->m_budget = budget;
+                    this->trim();
+                }
+                
+                inline void clear()
+                {
+                    while (!this->m_entries.empty())
+                    {
+                        this->erase(--this->m_entries.end());
+                    }
+                }
+                
+                inline ScriptCacheStats getStats() const
+                {
+                    ScriptCacheStats stats;
+                    stats.hits = this->m_hits;
+                    stats.misses = this->m_misses;
+                    stats.evictions = this->m_evictions;
+                    stats.entries = this->m_entries.size();
+                    stats.bytes = this->m_bytes;
+                    stats.budget = this->m_budget;
+                    return stats;
+                }
+            private:
+                struct Entry
+                {
+                    boost::uint64_t hash;
+                    std::string scriptCode;
+                    std::string fileName;
+                    Persistent<UnboundScript, CopyablePersistentTraits<UnboundScript> > script;
+                };
+                
+                typedef std::list<Entry> TEntriesList;
+                typedef boost::unordered_map<boost::uint64_t, TEntriesList::iterator> TEntriesIndex;
+                
+                Isolate *m_isolationScope;
+                CodeCache *m_codeCache;
+                TEntriesList m_entries; // Ordered from the most to the least recently used
+                TEntriesIndex m_index;
+                
+                size_t m_budget;
+                size_t m_bytes;
+                
+                size_t m_hits;
+                size_t m_misses;
+                size_t m_evictions;
+                
+                inline Local<UnboundScript> compileScript(const std::string &scriptCode, const std::string &fileName)
+                {
+                    if (this->m_codeCache != NULL)
+                    {
+                        return this->m_codeCache->compile(scriptCode, fileName);
+                    }
+                    
+                    return compile_unbound_script(this->m_isolationScope, scriptCode, fileName);
+                }
+                
+                inline size_t entrySize(const std::string &scriptCode, const std::string &fileName) const
+                {
+                    return scriptCode.size() + fileName.size() + sizeof(Entry);
+                }
+                
+                inline void erase(TEntriesList::iterator entry)
+                {
+                    this->m_bytes -= this->entrySize(entry->scriptCode, entry->fileName);
+                    this->m_index.erase(entry->hash);
+                    
+                    entry->script.Reset();
+                    this->m_entries.erase(entry);
+                }
+                
+                /* Evict the least recently used entries until we fit into the budget */
+                inline void trim()
+                {
+                    while (this->m_bytes > this->m_budget && !this->m_entries.empty())
+                    {
+                        this->erase(--this->m_entries.end());
+                        ++this->m_evictions;
+                    }
+                }
+            };
+        }
+    }
+}
+
+#endif
@@ -169,6 +169,28 @@ namespace v8 { namespace bridge {
 #           undef V8_FN_CC
 #       endif // defined(V8_ENABLE_FASTCALL)
 #   undef V8_LIST_INC
+    
+    //  Callable objects (lambdas, functors, std::function etc.) are described
+    //  by the signature of their operator(), without the hidden "this" argument,
+    //  so they can be invoked exactly like a free function::
+    //
+    //      get_callable_signature([](int a, int b) { return a * b; })
+    //          => mpl::vector3<int, int, int>
+    //
+    //  Note that overloaded or templated call operators (e.g. generic lambdas)
+    //  can't be resolved and should be passed with an explicit signature.
+    
+    template <class TCallable>
+    struct callable_signature
+    {
+        typedef decltype(get_call_operator_signature(&TCallable::operator())) type;
+    };
+    
+    template <class TCallable>
+    inline typename callable_signature<TCallable>::type get_callable_signature(const TCallable&)
+    {
+        return typename callable_signature<TCallable>::type();
+    }
     // }
 }} // namespace
 #   endif // v8bridge_signature_hpp
@@ -217,6 +239,13 @@ get_signature(TResult(V8_FN_CC TClass::*)(BOOST_PP_ENUM_PARAMS_Z(1, N, T)) Q, TT
     return V8_LIST_INC(BOOST_PP_INC(N))<TResult, BOOST_DEDUCED_TYPENAME most_derived<TTarget, TClass>::type& BOOST_PP_ENUM_TRAILING_PARAMS_Z(1, N, T)>();
 }
 
+template <class TResult, class TClass BOOST_PP_ENUM_TRAILING_PARAMS_Z(1, N, class T) >
+inline V8_LIST_INC(N)<TResult BOOST_PP_ENUM_TRAILING_PARAMS_Z(1, N, T) >
+get_call_operator_signature(TResult(V8_FN_CC TClass::*) (BOOST_PP_ENUM_PARAMS_Z(1, N, T)) Q)
+{
+    return V8_LIST_INC(N)<TResult BOOST_PP_ENUM_TRAILING_PARAMS_Z(1, N, T)>();
+}
+
 #       undef Q
 #       undef N
 #   endif // BOOST_PP_ITERATION_DEPTH()
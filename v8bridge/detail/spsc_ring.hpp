@@ -0,0 +1,162 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef v8bridge_spsc_ring_hpp
+#define v8bridge_spsc_ring_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+
+namespace v8
+{
+    namespace bridge
+    {
+        namespace detail
+        {
+            /**
+             * Bounded lock-free single-producer single-consumer ring of variable sized records.
+             *
+             * Each record is a tag and a bytes payload, copied in place (so pushing never allocates).
+             * push should only be called by a single (producer) thread and pop by a single (consumer) thread.
+             * When the ring doesn't have enough free space, push fails instead of blocking.
+             */
+            class SPSCRingBuffer
+            {
+            public:
+                SPSCRingBuffer(size_t capacity) : m_capacity(8), m_head(0), m_tail(0)
+                {
+                    /* Round the capacity up to a power of two, so positions can be masked */
+                    while (this->m_capacity < capacity)
+                    {
+                        this->m_capacity <<= 1;
+                    }
+                    
+                    this->m_buffer = new char[this->m_capacity];
+                }
+                
+                ~SPSCRingBuffer()
+                {
+                    delete [] this->m_buffer;
+                }
+                
+                /**
+                 * Push a record. Returns false if there's not enough free space for it.
+                 */
+                inline bool push(boost::uint32_t tag, const char *data, boost::uint32_t length)
+                {
+                    size_t head = this->m_head.load(boost::memory_order_relaxed);
+                    size_t tail = this->m_tail.load(boost::memory_order_acquire);
+                    
+                    if (sizeof(Header) + length > this->m_capacity - (head - tail))
+                    {
+                        return false;
+                    }
+                    
+                    Header header = { length, tag };
+                    this->write(head, reinterpret_cast<const char *>(&header), sizeof(Header));
+                    this->write(head + sizeof(Header), data, length);
+                    
+                    this->m_head.store(head + sizeof(Header) + length, boost::memory_order_release);
+                    return true;
+                }
+                
+                /**
+                 * Pop the oldest record. Returns false if the ring is empty.
+                 */
+                inline bool pop(boost::uint32_t &tag, std::string &data)
+                {
+                    size_t tail = this->m_tail.load(boost::memory_order_relaxed);
+                    size_t head = this->m_head.load(boost::memory_order_acquire);
+                    
+                    if (head == tail)
+                    {
+                        return false;
+                    }
+                    
+                    Header header;
+                    this->read(tail, reinterpret_cast<char *>(&header), sizeof(Header));
+                    
+                    data.resize(header.length);
+                    if (header.length > 0)
+                    {
+                        this->read(tail + sizeof(Header), &data[0], header.length);
+                    }
+                    tag = header.tag;
+                    
+                    this->m_tail.store(tail + sizeof(Header) + header.length, boost::memory_order_release);
+                    return true;
+                }
+                
+                inline bool empty() const
+                {
+                    return this->m_head.load(boost::memory_order_acquire) == this->m_tail.load(boost::memory_order_acquire);
+                }
+                
+                inline size_t capacity() const { return this->m_capacity; }
+            private:
+                struct Header
+                {
+                    boost::uint32_t length;
+                    boost::uint32_t tag;
+                };
+                
+                SPSCRingBuffer(const SPSCRingBuffer &);
+                SPSCRingBuffer &operator=(const SPSCRingBuffer &);
+                
+                inline void write(size_t position, const char *data, size_t length)
+                {
+                    size_t offset = position & (this->m_capacity - 1);
+                    size_t first = std::min(length, this->m_capacity - offset);
+                    
+                    std::memcpy(this->m_buffer + offset, data, first);
+                    std::memcpy(this->m_buffer, data + first, length - first);
+                }
+                
+                inline void read(size_t position, char *data, size_t length) const
+                {
+                    size_t offset = position & (this->m_capacity - 1);
+                    size_t first = std::min(length, this->m_capacity - offset);
+                    
+                    std::memcpy(data, this->m_buffer + offset, first);
+                    std::memcpy(data + first, this->m_buffer, length - first);
+                }
+                
+                char *m_buffer;
+                size_t m_capacity;
+                boost::atomic<size_t> m_head; // Written by the producer
+                boost::atomic<size_t> m_tail; // Written by the consumer
+            };
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,107 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef v8bridge_struct_shape_hpp
+#define v8bridge_struct_shape_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <vector>
+
+namespace v8
+{
+    namespace bridge
+    {
+        namespace detail
+        {
+            /* Specialized by V8BRIDGE_STRUCT (see struct_conversion.hpp) */
+            template <class TStruct>
+            struct StructDescriptor;
+            
+            /**
+             * The JS "shape" of a native struct declared with V8BRIDGE_STRUCT.
+             *
+             * Holds the struct internalized property keys and an object template that pre-declares
+             * these properties (in the descriptor order). Since every converted object is created from the same
+             * template and its fields are assigned in the same order, all the objects share one hidden class.
+             */
+            class V8_DECL StructShape
+            {
+            public:
+                StructShape(Isolate *isolationScope, const char *const *fieldNames, size_t fieldsCount)
+                : m_isolationScope(isolationScope)
+                {
+                    HandleScope handle_scope(isolationScope);
+                    
+                    Local<ObjectTemplate> templ = ObjectTemplate::New(isolationScope);
+                    
+                    this->m_keys.reserve(fieldsCount);
+                    for (size_t i = 0; i < fieldsCount; ++i)
+                    {
+                        Local<String> key = String::NewFromUtf8(isolationScope, fieldNames[i], String::kInternalizedString);
+                        
+                        templ->Set(key, Undefined(isolationScope));
+                        this->m_keys.push_back(TKeyHandle(isolationScope, key));
+                    }
+                    
+                    this->m_template.Reset(isolationScope, templ);
+                }
+                
+                ~StructShape()
+                {
+                    for (TKeysList::iterator it = this->m_keys.begin(); it != this->m_keys.end(); ++it)
+                    {
+                        it->Reset();
+                    }
+                    
+                    this->m_template.Reset();
+                }
+                
+                inline size_t getFieldsCount() const { return this->m_keys.size(); }
+                
+                inline Local<String> getKey(size_t index)
+                {
+                    return Local<String>::New(this->m_isolationScope, this->m_keys[index]);
+                }
+                
+                inline Local<Object> newInstance()
+                {
+                    return Local<ObjectTemplate>::New(this->m_isolationScope, this->m_template)->NewInstance();
+                }
+            private:
+                typedef Persistent<String, CopyablePersistentTraits<String> > TKeyHandle;
+                typedef std::vector<TKeyHandle> TKeysList;
+                
+                Isolate *m_isolationScope;
+                TKeysList m_keys;
+                Persistent<ObjectTemplate> m_template;
+            };
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,134 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef v8bridge_tasks_hpp
+#define v8bridge_tasks_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <exception>
+#include <future>
+#include <boost/shared_ptr.hpp>
+#include <boost/type_traits/is_void.hpp>
+#include <boost/utility/enable_if.hpp>
+
+/* The number of posted tasks that are run between microtasks checkpoints (see ScriptingEngine::runPending) */
+#ifndef V8BRIDGE_MICROTASKS_BATCH_SIZE
+#   define V8BRIDGE_MICROTASKS_BATCH_SIZE 64
+#endif
+
+namespace v8
+{
+    namespace bridge
+    {
+        namespace detail
+        {
+            /**
+             * Run the isolation scope pending microtasks (e.g. promise reactions).
+             */
+            inline void run_microtasks(Isolate *isolate)
+            {
+#if V8BRIDGE_V8_VERSION_AT_LEAST(7, 4)
+                isolate->PerformMicrotaskCheckpoint();
+#elif V8BRIDGE_V8_VERSION_AT_LEAST(3, 28)
+                isolate->RunMicrotasks();
+#else
+                V8::RunMicrotasks(isolate);
+#endif
+            }
+            
+            /**
+             * Fulfill the given promise with the result of the given callable (or with the exception it raised).
+             */
+            template <class TResult, class TCallable, class TArg>
+            inline typename boost::disable_if<boost::is_void<TResult> >::type
+            fulfill_promise(std::promise<TResult> &promise, TCallable &callable, TArg &arg)
+            {
+                try
+                {
+                    promise.set_value(callable(arg));
+                }
+                catch (...)
+                {
+                    promise.set_exception(std::current_exception());
+                }
+            }
+            
+            template <class TResult, class TCallable, class TArg>
+            inline typename boost::enable_if<boost::is_void<TResult> >::type
+            fulfill_promise(std::promise<TResult> &promise, TCallable &callable, TArg &arg)
+            {
+                try
+                {
+                    callable(arg);
+                    promise.set_value();
+                }
+                catch (...)
+                {
+                    promise.set_exception(std::current_exception());
+                }
+            }
+            
+            /**
+             * A posted task that fulfills a promise with the result of the given callable.
+             * The promise is shared, so the task stays copyable (as required by boost::function).
+             */
+            template <class TResult, class TCallable, class TArg>
+            struct PromisedTask
+            {
+                PromisedTask(const TCallable &callable) : callable(callable), promise(new std::promise<TResult>()) { }
+                
+                inline void operator()(TArg &arg)
+                {
+                    fulfill_promise<TResult>(*this->promise, this->callable, arg);
+                }
+                
+                TCallable callable;
+                boost::shared_ptr<std::promise<TResult> > promise;
+            };
+            
+            /**
+             * Evaluates a script (used by ScriptingEngine::postEval).
+             */
+            template <class TResult, class TEngine>
+            struct EvalTask
+            {
+                EvalTask(const std::string &scriptCode, const std::string &fileName) : scriptCode(scriptCode), fileName(fileName) { }
+                
+                inline TResult operator()(TEngine &engine)
+                {
+                    return engine.template eval<TResult>(this->scriptCode, this->fileName);
+                }
+                
+                std::string scriptCode;
+                std::string fileName;
+            };
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,234 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef v8bridge_timing_wheel_hpp
+#define v8bridge_timing_wheel_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <algorithm>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace v8
+{
+    namespace bridge
+    {
+        namespace detail
+        {
+            /**
+             * A timer scheduled in a TimingWheel. Timers are intrusive list nodes, so (un)scheduling never allocates.
+             */
+            struct TimerNode
+            {
+                TimerNode() : expires(0), level(0), previous(NULL), next(NULL) { }
+                
+                inline bool isScheduled() const { return this->next != NULL; }
+                
+                boost::uint64_t expires;
+                int level;
+                TimerNode *previous;
+                TimerNode *next;
+            };
+            
+            /**
+             * Hierarchical timing wheel (4 levels of 256 slots, covering 2^32 ticks).
+             *
+             * A timer is placed in the slot of the lowest level that covers its remaining time. Once the lower level completes
+             * a revolution, the matching slot of the upper level is cascaded (its timers are re-placed in the lower levels).
+             * Scheduling and cancelling are O(1), and advancing costs O(1) per tick plus the cascaded and expired timers
+             * (ticks in which the lower levels are empty are skipped).
+             */
+            class TimingWheel
+            {
+            public:
+                enum { kLevels = 4, kSlotBits = 8, kSlots = 1 << kSlotBits, kSlotMask = kSlots - 1 };
+                
+                TimingWheel(boost::uint64_t now = 0) : m_current(now), m_count(0)
+                {
+                    for (int level = 0; level < kLevels; ++level)
+                    {
+                        this->m_levelCounts[level] = 0;
+                        
+                        for (int slot = 0; slot < kSlots; ++slot)
+                        {
+                            TimerNode &head = this->m_slots[level][slot];
+                            head.previous = head.next = &head;
+                        }
+                    }
+                }
+                
+                /**
+                 * Schedule the given (unscheduled) timer to expire on the given tick.
+                 * Timers that are already due expire on the next advance.
+                 */
+                inline void schedule(TimerNode *node, boost::uint64_t expires)
+                {
+                    node->expires = expires < this->m_current ? this->m_current : expires;
+                    this->place(node);
+                    ++this->m_count;
+                }
+                
+                inline void cancel(TimerNode *node)
+                {
+                    if (!node->isScheduled())
+                    {
+                        return;
+                    }
+                    
+                    this->unlink(node);
+                    --this->m_count;
+                }
+                
+                /**
+                 * Advance the wheel up to (and including) the given tick, appending the expired timers to the given list.
+                 * The expired timers are unscheduled, so they can be scheduled again.
+                 */
+                inline void advance(boost::uint64_t now, std::vector<TimerNode *> &expired)
+                {
+                    while (this->m_current <= now)
+                    {
+                        /* Nothing is scheduled, there's no need to tick */
+                        if (this->m_count == 0)
+                        {
+                            this->m_current = now + 1;
+                            return;
+                        }
+                        
+                        /* Skip to the next boundary of the lowest non-empty level */
+                        int emptyLevels = 0;
+                        while (emptyLevels < kLevels - 1 && this->m_levelCounts[emptyLevels] == 0)
+                        {
+                            ++emptyLevels;
+                        }
+                        
+                        boost::uint64_t granularity = boost::uint64_t(1) << (emptyLevels * kSlotBits);
+                        if (emptyLevels > 0 && (this->m_current & (granularity - 1)) != 0)
+                        {
+                            this->m_current = std::min((this->m_current | (granularity - 1)) + 1, now + 1);
+                            continue;
+                        }
+                        
+                        int index = static_cast<int>(this->m_current & kSlotMask);
+                        
+                        /* The lower level completed a revolution, cascade the upper levels */
+                        for (int level = 1; level < kLevels && index == 0; ++level)
+                        {
+                            index = static_cast<int>((this->m_current >> (level * kSlotBits)) & kSlotMask);
+                            this->cascade(this->m_slots[level][index]);
+                        }
+                        
+                        /* Expire the current slot */
+                        TimerNode &head = this->m_slots[0][this->m_current & kSlotMask];
+                        while (head.next != &head)
+                        {
+                            TimerNode *node = head.next;
+                            this->unlink(node);
+                            --this->m_count;
+                            
+                            expired.push_back(node);
+                        }
+                        
+                        ++this->m_current;
+                    }
+                }
+                
+                inline size_t size() const { return this->m_count; }
+                
+                /* The next tick to be processed */
+                inline boost::uint64_t getCurrentTick() const { return this->m_current; }
+            private:
+                TimingWheel(const TimingWheel &);
+                TimingWheel &operator=(const TimingWheel &);
+                
+                inline void place(TimerNode *node)
+                {
+                    boost::uint64_t delta = node->expires - this->m_current;
+                    
+                    int level = 0;
+                    while (level < kLevels - 1 && delta >= (boost::uint64_t(1) << ((level + 1) * kSlotBits)))
+                    {
+                        ++level;
+                    }
+                    
+                    /* Beyond the wheel range - park it in the farthest slot, it's re-placed once cascaded */
+                    boost::uint64_t expires = node->expires;
+                    if (delta >= (boost::uint64_t(1) << (kLevels * kSlotBits)))
+                    {
+                        expires = this->m_current + (boost::uint64_t(1) << (kLevels * kSlotBits)) - 1;
+                    }
+                    
+                    TimerNode &head = this->m_slots[level][(expires >> (level * kSlotBits)) & kSlotMask];
+                    
+                    node->level = level;
+                    ++this->m_levelCounts[level];
+                    
+                    node->previous = head.previous;
+                    node->next = &head;
+                    head.previous->next = node;
+                    head.previous = node;
+                }
+                
+                inline void cascade(TimerNode &head)
+                {
+                    if (head.next == &head)
+                    {
+                        return;
+                    }
+                    
+                    /* Detach the slot list first, since the timers may be re-placed in the same slot */
+                    TimerNode *node = head.next;
+                    head.previous->next = NULL;
+                    head.previous = head.next = &head;
+                    
+                    while (node != NULL)
+                    {
+                        TimerNode *next = node->next;
+                        --this->m_levelCounts[node->level];
+                        this->place(node);
+                        node = next;
+                    }
+                }
+                
+                inline void unlink(TimerNode *node)
+                {
+                    --this->m_levelCounts[node->level];
+                    node->previous->next = node->next;
+                    node->next->previous = node->previous;
+                    node->previous = node->next = NULL;
+                }
+                
+                TimerNode m_slots[kLevels][kSlots];
+                boost::uint64_t m_current;
+                size_t m_count;
+                size_t m_levelCounts[kLevels];
+            };
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,133 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * This file contains helpers used to interact with JS typed arrays (ArrayBuffer backing stores)
+ * from native element types.
+ */
+
+#ifndef v8bridge_typed_array_hpp
+#define v8bridge_typed_array_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <string.h>
+#include <boost/cstdint.hpp>
+
+namespace v8
+{
+    namespace bridge
+    {
+        namespace detail
+        {
+            /* Largest integer that can be represented in a double without precision loss (2^53 - 1) */
+            const double kMaxSafeInteger = 9007199254740991.0;
+            
+            /**
+             * Maps a native element type to its JS typed array.
+             * The default (non-specialized) declaration means that there's no matching typed array.
+             */
+            template <class TElement>
+            struct TypedArrayTraits
+            {
+                enum { isSupported = false };
+            };
+            
+#define V8BRIDGE_TYPED_ARRAY_TRAITS(element, array) \
+            template <> \
+            struct TypedArrayTraits<element> \
+            { \
+                enum { isSupported = true }; \
+                typedef v8::array type; \
+                \
+                inline static bool is(Handle<Value> value) { return value->Is##array(); } \
+            }
+            
+            V8BRIDGE_TYPED_ARRAY_TRAITS(boost::int8_t, Int8Array);
+            V8BRIDGE_TYPED_ARRAY_TRAITS(boost::uint8_t, Uint8Array);
+            V8BRIDGE_TYPED_ARRAY_TRAITS(boost::int16_t, Int16Array);
+            V8BRIDGE_TYPED_ARRAY_TRAITS(boost::uint16_t, Uint16Array);
+            V8BRIDGE_TYPED_ARRAY_TRAITS(boost::int32_t, Int32Array);
+            V8BRIDGE_TYPED_ARRAY_TRAITS(boost::uint32_t, Uint32Array);
+            V8BRIDGE_TYPED_ARRAY_TRAITS(float, Float32Array);
+            V8BRIDGE_TYPED_ARRAY_TRAITS(double, Float64Array);
+#if V8BRIDGE_HAS_BIGINT
+            V8BRIDGE_TYPED_ARRAY_TRAITS(boost::int64_t, BigInt64Array);
+            V8BRIDGE_TYPED_ARRAY_TRAITS(boost::uint64_t, BigUint64Array);
+#endif
+            
+#undef V8BRIDGE_TYPED_ARRAY_TRAITS
+            
+            /**
+             * Get the raw backing store pointer of the given array buffer.
+             */
+            inline void *array_buffer_data(Local<ArrayBuffer> buffer)
+            {
+#if V8BRIDGE_V8_VERSION_AT_LEAST(8, 0)
+                return buffer->GetBackingStore()->Data();
+#else
+                return buffer->GetContents().Data();
+#endif
+            }
+            
+            /**
+             * Get the first element of the given typed array view.
+             */
+            template <class TElement>
+            inline TElement *typed_array_data(Local<ArrayBufferView> view)
+            {
+                return reinterpret_cast<TElement *>(static_cast<char *>(array_buffer_data(view->Buffer())) + view->ByteOffset());
+            }
+            
+            /**
+             * Allocate a new typed array with the given number of elements.
+             */
+            template <class TElement>
+            inline Local<typename TypedArrayTraits<TElement>::type> new_typed_array(Isolate *isolationScope, size_t length)
+            {
+                Local<ArrayBuffer> buffer = ArrayBuffer::New(isolationScope, length * sizeof(TElement));
+                return TypedArrayTraits<TElement>::type::New(buffer, 0, length);
+            }
+            
+            /**
+             * Allocate a new typed array and copy the given elements into it.
+             */
+            template <class TElement>
+            inline Local<typename TypedArrayTraits<TElement>::type> new_typed_array(Isolate *isolationScope, const TElement *elements, size_t length)
+            {
+                Local<typename TypedArrayTraits<TElement>::type> array = new_typed_array<TElement>(isolationScope, length);
+                if (length > 0)
+                {
+                    memcpy(typed_array_data<TElement>(array), elements, length * sizeof(TElement));
+                }
+                return array;
+            }
+        }
+    }
+}
+
+#endif
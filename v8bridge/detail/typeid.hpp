@@ -28,10 +28,40 @@
 #ifndef V8Bridge_typeid_h
 #define V8Bridge_typeid_h
 
+#include <stddef.h>
+#include <string>
+#include <boost/atomic.hpp>
+
 namespace v8
 {
     namespace bridge
     {
+        namespace detail
+        {
+            /* Hands out the next free type index (see TypeIndex) */
+            inline size_t next_type_index()
+            {
+                static boost::atomic<size_t> s_counter(0);
+                return s_counter++;
+            }
+        }
+        
+        /**
+         * Provides a small, dense and process-wide unique integer for the given type.
+         *
+         * Indexes are assigned on first use (so they're not stable between runs)
+         * and can be used to index flat tables instead of looking up types by their name.
+         */
+        template <class TClass>
+        struct TypeIndex
+        {
+            inline static size_t value()
+            {
+                static const size_t s_index = detail::next_type_index();
+                return s_index;
+            }
+        };
+        
         /*
          * This file is been used to provide simple interface for TypeId representation.
          *
@@ -42,6 +72,8 @@ namespace v8
          *
          * As a fallback, it's using the typeid() operator - "And May the Odds be in Your Favor".
          *
+         * The name is intended for diagnostics. Use index() (see TypeIndex) in order to identify types.
+         *
          * For more info, See: http://stackoverflow.com/questions/1666802/is-there-a-class-macro-in-c
          */
         
@@ -55,44 +87,54 @@ namespace v8
         public:
             TypeId() { }
             
-            bool operator!=(TypeId const& other) const
+            template <class TOther>
+            bool operator!=(TypeId<TOther> const& other) const
             {
-                return this->name() != other->name();
+                return this->index() != other.index();
             }
             
-            bool operator==(TypeId const& other) const
+            template <class TOther>
+            bool operator==(TypeId<TOther> const& other) const
+            {
+                return this->index() == other.index();
+            }
+            
+            inline size_t index() const
             {
-                return this->name() == other->name();
+                return TypeIndex<TClass>::value();
             }
             
-            inline std::string name() const
+            /* The name is parsed once per type and cached */
+            inline const std::string& name() const
             {
-                return this->getClassName(__PRETTY_FUNCTION__);
+                static const std::string s_name = this->getClassName(__PRETTY_FUNCTION__);
+                return s_name;
             }
             
         private:
             inline std::string getClassName(std::string prettyFunction) const
             {
                 /*
-                 * Sample input: std::string v8::bridge::TypeId<Foo<Car> >::name() const [TClass = Foo<Car>]Foo<Car>
+                 * Sample input (clang): const std::string &v8::bridge::TypeId<Foo<Car> >::name() const [TClass = Foo<Car>]
+                 * Sample input (gcc): const string& v8::bridge::TypeId<TClass>::name() const [with TClass = Foo<Car>; std::string = ...]
                  */
                 
                 //-------------------------------------------------
-                //  Search for the "[TClass = " prefix
+                //  Search for the "TClass = " prefix
                 //-------------------------------------------------
                 
-                size_t bracketsPrefix = prettyFunction.find("[TClass = ");
+                size_t bracketsPrefix = prettyFunction.find("TClass = ");
                 if (bracketsPrefix == std::string::npos)
                 {
                     return "<Unknown>";
                 }
                 
-                bracketsPrefix += 10; //strlen("[TClass = ");
+                bracketsPrefix += 9; //strlen("TClass = ");
                 
                 //-------------------------------------------------
-                //  Search for the brackets suffix
+                //  Search for the brackets suffix (or the next template argument)
                 //-------------------------------------------------
-                size_t bracketsSufix = prettyFunction.find("]", bracketsPrefix - 1);
+                size_t bracketsSufix = prettyFunction.find_first_of(";]", bracketsPrefix);
                 if (bracketsSufix == std::string::npos)
                 {
                     return "<Unknown>";
@@ -114,19 +156,28 @@ namespace v8
 		public:
 			TypeId() { }
             
-			bool operator!=(TypeId const& other) const
+			template <class TOther>
+			bool operator!=(TypeId<TOther> const& other) const
 			{
-				return this->name() != other->name();
+				return this->index() != other.index();
 			}
             
-			bool operator==(TypeId const& other) const
+			template <class TOther>
+			bool operator==(TypeId<TOther> const& other) const
 			{
-				return this->name() == other->name();
+				return this->index() == other.index();
 			}
             
-			inline std::string name() const
+			inline size_t index() const
 			{
-				return this->getClassName(__FUNCTION__);
+				return TypeIndex<TClass>::value();
+			}
+            
+			/* The name is parsed once per type and cached */
+			inline const std::string& name() const
+			{
+				static const std::string s_name = this->getClassName(__FUNCTION__);
+				return s_name;
 			}
             
 		private:
@@ -197,6 +248,11 @@ namespace v8
                 return *id == *other.id;
             }
             
+            inline size_t index() const
+            {
+                return TypeIndex<TClass>::value();
+            }
+            
             inline char const* name() const
             {
                 return id->name();
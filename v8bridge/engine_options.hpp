@@ -0,0 +1,199 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef v8bridge_engine_options_hpp
+#define v8bridge_engine_options_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <stddef.h>
+#include <stdexcept>
+#include <string>
+
+/* Engine-owned isolation scopes rely on Isolate::CreateParams and ArrayBuffer::Allocator::NewDefaultAllocator */
+#ifndef V8BRIDGE_HAS_ENGINE_OPTIONS
+#   define V8BRIDGE_HAS_ENGINE_OPTIONS V8BRIDGE_V8_VERSION_AT_LEAST(6, 0)
+#endif
+
+#if V8BRIDGE_HAS_ENGINE_OPTIONS
+
+namespace v8
+{
+    namespace bridge
+    {
+        /**
+         * Creation parameters for a ScriptingEngine that creates (and owns) its own isolation scope.
+         * Zero/empty values mean "use the V8 default".
+         *
+         * For example:
+         *      EngineOptions options;
+         *      options.maxOldGenerationSizeInBytes = 64 * 1024 * 1024;
+         *      ScriptingEngine *engine = new ScriptingEngine(options);
+         *
+         * V8 flags (e.g. --jitless) are process-wide and are not part of the engine options. See ProcessOptions.
+         */
+        struct EngineOptions
+        {
+            /* Heap limits. The V8 versions this library supports don't allow setting the initial heap sizes, only the maximum ones. */
+            size_t maxYoungGenerationSizeInBytes = 0;
+            size_t maxOldGenerationSizeInBytes = 0;
+            size_t codeRangeSizeInBytes = 0;
+            
+            /* Configure the heap limits based on the available memory (see ResourceConstraints::ConfigureDefaults).
+                Explicit limits above take precedence. */
+            size_t physicalMemoryInBytes = 0;
+            size_t virtualMemoryLimitInBytes = 0;
+            
+            /* The JS stack size, starting from the stack position in which the engine was created, or, for engines that are
+                handed off between threads, the position in which the engine is attached to a thread (see ScriptingEngine::acquireThread). */
+            size_t stackSizeInBytes = 0;
+            
+            /* The ArrayBuffer allocator. If not specified, the engine creates (and owns) the V8 default allocator.
+                A given allocator is not owned by the engine and must outlive it. */
+            ArrayBuffer::Allocator *arrayBufferAllocator = NULL;
+            
+            /* Startup snapshot and its external references (see SnapshotBuilder). Not owned by the engine. */
+            StartupData *snapshotBlob = NULL;
+            const intptr_t *externalReferences = NULL;
+            
+            /* Detach the engine from the creating thread once it's initialized, so it can be used by other threads
+                (one at a time) through ScriptingEngine::ThreadScope (or EnginePool) */
+            bool threadHandoff = false;
+        };
+        
+        /**
+         * Process-wide V8 configuration. V8 flags affect every isolation scope in the process, and some of them
+         * (e.g. jitless) must be set before V8 is initialized, so they're applied once, using configure_process.
+         *
+         * For example:
+         *      ProcessOptions options;
+         *      options.jitless = true;
+         *      configure_process(options);
+         *
+         *      V8::InitializePlatform(platform);
+         *      V8::Initialize();
+         */
+        struct ProcessOptions
+        {
+            /* V8 command line flags (e.g. "--max-lazy --stack-size=512") */
+            std::string flags;
+            bool jitless = false;
+            bool liteMode = false;
+        };
+        
+        /**
+         * Apply the given process-wide options. Should be called once, before V8::Initialize.
+         * Throws std::logic_error if the process was already configured.
+         */
+        inline void configure_process(const ProcessOptions &options)
+        {
+            static bool configured = false;
+            if (configured)
+            {
+                throw std::logic_error("The V8 process options can be configured only once (before V8 is initialized).");
+            }
+            configured = true;
+            
+            std::string flags = options.flags;
+            if (options.jitless)
+            {
+                flags += " --jitless";
+            }
+            
+            if (options.liteMode)
+            {
+                flags += " --lite-mode";
+            }
+            
+            if (!flags.empty())
+            {
+                V8::SetFlagsFromString(flags.c_str(), (int)flags.size());
+            }
+        }
+        
+        namespace detail
+        {
+            /**
+             * Create a new isolation scope from the given options.
+             * @param ownedAllocator - set to the ArrayBuffer allocator created for the isolation scope (if any), which should be
+             *  deleted after the isolation scope is disposed.
+             */
+            inline Isolate *create_isolate(const EngineOptions &options, ArrayBuffer::Allocator *&ownedAllocator)
+            {
+                //-------------------------------------------------
+                //  Creation params
+                //-------------------------------------------------
+                
+                Isolate::CreateParams params;
+                
+                ownedAllocator = NULL;
+                if (options.arrayBufferAllocator != NULL)
+                {
+                    params.array_buffer_allocator = options.arrayBufferAllocator;
+                }
+                else
+                {
+                    ownedAllocator = ArrayBuffer::Allocator::NewDefaultAllocator();
+                    params.array_buffer_allocator = ownedAllocator;
+                }
+                
+                params.snapshot_blob = options.snapshotBlob;
+                params.external_references = options.externalReferences;
+                
+                ResourceConstraints &constraints = params.constraints;
+                if (options.physicalMemoryInBytes != 0)
+                {
+                    constraints.ConfigureDefaults(options.physicalMemoryInBytes, options.virtualMemoryLimitInBytes);
+                }
+                
+                /* The young generation consists of 3 semi-spaces */
+                if (options.maxYoungGenerationSizeInBytes != 0)
+                {
+                    constraints.set_max_semi_space_size_in_kb(options.maxYoungGenerationSizeInBytes / 3 / 1024);
+                }
+                
+                if (options.maxOldGenerationSizeInBytes != 0)
+                {
+                    constraints.set_max_old_space_size(options.maxOldGenerationSizeInBytes / (1024 * 1024));
+                }
+                
+                if (options.codeRangeSizeInBytes != 0)
+                {
+                    constraints.set_code_range_size(options.codeRangeSizeInBytes / (1024 * 1024));
+                }
+                
+                Isolate *isolate = Isolate::New(params);
+                
+                return isolate;
+            }
+        }
+    }
+}
+
+#endif // V8BRIDGE_HAS_ENGINE_OPTIONS
+
+#endif
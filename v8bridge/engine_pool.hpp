@@ -0,0 +1,362 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef v8bridge_engine_pool_hpp
+#define v8bridge_engine_pool_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
+
+#include <v8bridge/engine_options.hpp>
+#include <v8bridge/scripting_engine.hpp>
+
+#if V8BRIDGE_HAS_ENGINE_OPTIONS
+
+namespace v8
+{
+    namespace bridge
+    {
+        /**
+         * When should a pooled engine be replaced with a fresh one (checked when the engine is returned to the pool).
+         * Zero values disable the matching check.
+         */
+        struct EngineRecyclePolicy
+        {
+            size_t maxUses = 0;                 // Recycle after K leases
+            size_t maxHeapUsedInBytes = 0;      // Recycle once the used heap exceeds M bytes
+        };
+        
+        /**
+         * A pooled engine health counters (see EnginePool::getHealth).
+         */
+        struct EngineHealth
+        {
+            size_t uses;                // Leases since the engine was (re)created
+            size_t totalUses;           // Leases since the pool was created
+            size_t recycles;            // Number of times the engine was replaced
+            size_t recycleFailures;     // Number of times the engine replacement failed (the engine was kept)
+            size_t heapUsedInBytes;     // The used heap size, sampled when the engine was last returned
+        };
+        
+        /**
+         * A pool of pre-initialized scripting engines, each owning its own isolation scope.
+         *
+         * Each engine is created with the given options (in thread handoff mode) and passed to the initializer,
+         * which should apply the bindings (exposeFunction, exposeClass...) and evaluate the prelude scripts.
+         * Engines are checked out with EnginePool::Lease, which locks the engine isolation scope and attaches it
+         * to the calling thread for the lease lifetime.
+         *
+         * The free engines are kept in a lock-free (tagged) stack, so checking out and returning engines
+         * never blocks on a mutex while engines are available. A lease that has to wait for an engine sleeps
+         * until an engine is returned.
+         *
+         * For example:
+         *      EnginePool pool(std::thread::hardware_concurrency(), options, &setup_engine);
+         *      ...
+         *      // On any thread:
+         *      EnginePool::Lease lease(pool);
+         *      int result = lease->eval<int>("handle(request)");
+         */
+        class V8_DECL EnginePool
+        {
+        public:
+            typedef boost::function<void (ScriptingEngine *)> TInitializer;
+            
+            EnginePool(size_t size, const EngineOptions &options, TInitializer initializer, EngineRecyclePolicy policy = EngineRecyclePolicy())
+            : m_options(options), m_initializer(initializer), m_policy(policy), m_slots(size), m_head(kEmpty), m_waiters(0)
+            {
+                if (size == 0 || size >= kEmpty)
+                {
+                    throw std::runtime_error("EnginePool: invalid pool size.");
+                }
+                
+                this->m_options.threadHandoff = true;
+                
+                try
+                {
+                    for (size_t i = 0; i < size; ++i)
+                    {
+                        this->m_slots[i].engine = this->createEngine();
+                        this->push((boost::uint32_t)i);
+                    }
+                }
+                catch (...)
+                {
+                    /* The destructor won't run, so destroy the engines that were already created */
+                    for (TSlotsList::iterator it = this->m_slots.begin(); it != this->m_slots.end(); ++it)
+                    {
+                        delete it->engine;
+                    }
+                    
+                    throw;
+                }
+            }
+            
+            /**
+             * Destroy the pool engines. All the leases must be released before the pool is destroyed.
+             */
+            ~EnginePool()
+            {
+                for (TSlotsList::iterator it = this->m_slots.begin(); it != this->m_slots.end(); ++it)
+                {
+                    delete it->engine;
+                }
+            }
+            
+            /**
+             * Checks out an engine for the lease lifetime.
+             * The lease must be released on the thread that created it.
+             */
+            class Lease
+            {
+            public:
+                /**
+                 * @param wait - wait for an engine to become available (otherwise, the lease may be empty - see isValid).
+                 */
+                Lease(EnginePool &pool, bool wait = true) : m_pool(pool), m_index(kEmpty), m_scope(NULL)
+                {
+                    this->m_index = wait ? pool.pop() : pool.tryPop();
+                    if (this->m_index != kEmpty)
+                    {
+                        this->m_scope = new ScriptingEngine::ThreadScope(this->get());
+                    }
+                }
+                
+                ~Lease()
+                {
+                    if (this->m_index != kEmpty)
+                    {
+                        this->m_pool.release(this->m_index, this->m_scope);
+                    }
+                }
+                
+                inline bool isValid() const { return this->m_index != kEmpty; }
+                inline ScriptingEngine *get() const { return this->m_pool.m_slots[this->m_index].engine; }
+                inline ScriptingEngine *operator->() const { return this->get(); }
+            private:
+                Lease(const Lease &);
+                Lease &operator=(const Lease &);
+                
+                EnginePool &m_pool;
+                boost::uint32_t m_index;
+                ScriptingEngine::ThreadScope *m_scope;
+            };
+            
+            inline size_t getSize() const { return this->m_slots.size(); }
+            
+            /**
+             * Get the health counters of the engine in the given slot.
+             * The counters are updated when the engine is returned to the pool.
+             */
+            inline EngineHealth getHealth(size_t index) const
+            {
+                const Slot &slot = this->m_slots[index];
+                
+                EngineHealth health;
+                health.uses = slot.uses.load(boost::memory_order_relaxed);
+                health.totalUses = slot.totalUses.load(boost::memory_order_relaxed);
+                health.recycles = slot.recycles.load(boost::memory_order_relaxed);
+                health.recycleFailures = slot.recycleFailures.load(boost::memory_order_relaxed);
+                health.heapUsedInBytes = slot.heapUsedInBytes.load(boost::memory_order_relaxed);
+                return health;
+            }
+        private:
+            enum { kEmpty = 0xffffffff };
+            
+            struct Slot
+            {
+                ScriptingEngine *engine;
+                boost::atomic<boost::uint32_t> next; // The next free slot (valid while the slot is in the free stack)
+                
+                /* Health counters: written by the releasing thread, may be read by any thread (see getHealth) */
+                boost::atomic<size_t> uses;
+                boost::atomic<size_t> totalUses;
+                boost::atomic<size_t> recycles;
+                boost::atomic<size_t> recycleFailures;
+                boost::atomic<size_t> heapUsedInBytes;
+                
+                Slot() : engine(NULL), next(kEmpty), uses(0), totalUses(0), recycles(0), recycleFailures(0), heapUsedInBytes(0) { }
+                Slot(const Slot &other) : engine(other.engine), next(other.next.load()), uses(other.uses.load()), totalUses(other.totalUses.load()),
+                    recycles(other.recycles.load()), recycleFailures(other.recycleFailures.load()), heapUsedInBytes(other.heapUsedInBytes.load()) { }
+            };
+            
+            typedef std::vector<Slot> TSlotsList;
+            
+            EngineOptions m_options;
+            TInitializer m_initializer;
+            EngineRecyclePolicy m_policy;
+            TSlotsList m_slots;
+            
+            /* The free slots stack head: the slot index in the low 32 bits and a modification tag in the high 32 bits (avoids ABA) */
+            boost::atomic<boost::uint64_t> m_head;
+            
+            /* Leases that wait for a free engine */
+            boost::atomic<size_t> m_waiters;
+            std::mutex m_waitMutex;
+            std::condition_variable m_available;
+            
+            inline ScriptingEngine *createEngine()
+            {
+                ScriptingEngine *engine = new ScriptingEngine(this->m_options);
+                
+                if (this->m_initializer)
+                {
+                    try
+                    {
+                        ScriptingEngine::ThreadScope scope(engine);
+                        this->m_initializer(engine);
+                    }
+                    catch (...)
+                    {
+                        delete engine;
+                        throw;
+                    }
+                }
+                
+                return engine;
+            }
+            
+            inline void push(boost::uint32_t index)
+            {
+                boost::uint64_t head = this->m_head.load(boost::memory_order_relaxed);
+                boost::uint64_t newHead;
+                do
+                {
+                    this->m_slots[index].next.store((boost::uint32_t)head, boost::memory_order_relaxed);
+                    newHead = (((head >> 32) + 1) << 32) | index;
+                }
+                while (!this->m_head.compare_exchange_weak(head, newHead, boost::memory_order_release, boost::memory_order_relaxed));
+                
+                /* Wake up a waiting lease (if any). The waiters register (under the mutex) before checking the stack,
+                    so either they see the pushed engine or we see them. */
+                boost::atomic_thread_fence(boost::memory_order_seq_cst);
+                if (this->m_waiters.load(boost::memory_order_relaxed) != 0)
+                {
+                    std::lock_guard<std::mutex> lock(this->m_waitMutex);
+                    this->m_available.notify_one();
+                }
+            }
+            
+            inline boost::uint32_t tryPop()
+            {
+                boost::uint64_t head = this->m_head.load(boost::memory_order_acquire);
+                boost::uint64_t newHead;
+                do
+                {
+                    boost::uint32_t index = (boost::uint32_t)head;
+                    if (index == kEmpty)
+                    {
+                        return kEmpty;
+                    }
+                    
+                    newHead = (((head >> 32) + 1) << 32) | this->m_slots[index].next.load(boost::memory_order_relaxed);
+                }
+                while (!this->m_head.compare_exchange_weak(head, newHead, boost::memory_order_acquire, boost::memory_order_acquire));
+                
+                return (boost::uint32_t)head;
+            }
+            
+            inline boost::uint32_t pop()
+            {
+                boost::uint32_t index = this->tryPop();
+                if (index != kEmpty)
+                {
+                    return index;
+                }
+                
+                std::unique_lock<std::mutex> lock(this->m_waitMutex);
+                this->m_waiters.fetch_add(1, boost::memory_order_relaxed);
+                boost::atomic_thread_fence(boost::memory_order_seq_cst);
+                
+                while ((index = this->tryPop()) == kEmpty)
+                {
+                    this->m_available.wait(lock);
+                }
+                
+                this->m_waiters.fetch_sub(1, boost::memory_order_relaxed);
+                return index;
+            }
+            
+            /* Called by Lease on the leasing thread, while the engine is still attached */
+            inline void release(boost::uint32_t index, ScriptingEngine::ThreadScope *scope)
+            {
+                Slot &slot = this->m_slots[index];
+                size_t uses = slot.uses.fetch_add(1, boost::memory_order_relaxed) + 1;
+                slot.totalUses.fetch_add(1, boost::memory_order_relaxed);
+                
+                HeapStatistics statistics;
+                slot.engine->getActiveIsolationScope()->GetHeapStatistics(&statistics);
+                size_t heapUsedInBytes = statistics.used_heap_size();
+                slot.heapUsedInBytes.store(heapUsedInBytes, boost::memory_order_relaxed);
+                
+                delete scope;
+                
+                //-------------------------------------------------
+                //  Should we recycle the engine?
+                //-------------------------------------------------
+                
+                if ((this->m_policy.maxUses != 0 && uses >= this->m_policy.maxUses)
+                    || (this->m_policy.maxHeapUsedInBytes != 0 && heapUsedInBytes >= this->m_policy.maxHeapUsedInBytes))
+                {
+                    /* Called by ~Lease, so nothing may be raised from here. The replacement is created first,
+                        so the slot keeps the old (still usable) engine if the engine creation or the initializer fails. */
+                    ScriptingEngine *engine = NULL;
+                    try
+                    {
+                        engine = this->createEngine();
+                    }
+                    catch (...)
+                    {
+                        slot.recycleFailures.fetch_add(1, boost::memory_order_relaxed);
+                    }
+                    
+                    if (engine != NULL)
+                    {
+                        delete slot.engine;
+                        slot.engine = engine;
+                        slot.uses.store(0, boost::memory_order_relaxed);
+                        slot.heapUsedInBytes.store(0, boost::memory_order_relaxed);
+                        slot.recycles.fetch_add(1, boost::memory_order_relaxed);
+                    }
+                }
+                
+                this->push(index);
+            }
+        };
+    }
+}
+
+#endif // V8BRIDGE_HAS_ENGINE_OPTIONS
+
+#endif
@@ -0,0 +1,93 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef v8bridge_heap_limits_hpp
+#define v8bridge_heap_limits_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+/* Isolate::MemoryPressureNotification */
+#ifndef V8BRIDGE_HAS_MEMORY_PRESSURE
+#   define V8BRIDGE_HAS_MEMORY_PRESSURE V8BRIDGE_V8_VERSION_AT_LEAST(5, 3)
+#endif
+
+namespace v8
+{
+    namespace bridge
+    {
+        /**
+         * Raised when the used heap exceeds the engine heap budget after an evaluation (even after a full garbage collection).
+         * See ScriptingEngine::setHeapBudget.
+         */
+        class HeapBudgetExceededError : public std::runtime_error
+        {
+        public:
+            HeapBudgetExceededError(size_t usedHeapSize, size_t heapBudget) :
+            std::runtime_error(HeapBudgetExceededError::formatMessage(usedHeapSize, heapBudget)),
+            m_usedHeapSize(usedHeapSize), m_heapBudget(heapBudget) { }
+            
+            inline size_t getUsedHeapSize() const { return this->m_usedHeapSize; }
+            inline size_t getHeapBudget() const { return this->m_heapBudget; }
+        private:
+            size_t m_usedHeapSize;
+            size_t m_heapBudget;
+            
+            inline static std::string formatMessage(size_t usedHeapSize, size_t heapBudget)
+            {
+                std::stringstream io;
+                io << "The used heap size (" << usedHeapSize << " bytes) exceeds the engine heap budget (" << heapBudget << " bytes).";
+                return io.str();
+            }
+        };
+        
+        namespace detail
+        {
+            inline size_t get_used_heap_size(Isolate *isolate)
+            {
+                HeapStatistics stats;
+                isolate->GetHeapStatistics(&stats);
+                return stats.used_heap_size();
+            }
+            
+            /* Moved from V8 to Isolate in 3.28 */
+            inline void low_memory_notification(Isolate *isolate)
+            {
+#if V8BRIDGE_V8_VERSION_AT_LEAST(3, 28)
+                isolate->LowMemoryNotification();
+#else
+                V8::LowMemoryNotification();
+#endif
+            }
+        }
+    }
+}
+
+#endif
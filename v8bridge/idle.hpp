@@ -0,0 +1,86 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef v8bridge_idle_hpp
+#define v8bridge_idle_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+/* Isolate::IdleNotificationDeadline and platform::RunIdleTasks (the platform should be created with idle tasks support) */
+#ifndef V8BRIDGE_HAS_IDLE_TASKS
+#   define V8BRIDGE_HAS_IDLE_TASKS V8BRIDGE_V8_VERSION_AT_LEAST(5, 4)
+#endif
+
+#if V8BRIDGE_HAS_IDLE_TASKS
+#   include <libplatform/libplatform.h>
+#endif
+
+namespace v8
+{
+    namespace bridge
+    {
+        namespace detail
+        {
+            /**
+             * Let V8 perform idle time work (mainly garbage collection steps) for up to the given amount of seconds.
+             * Returns true if there's no more idle time work to do.
+             */
+#if V8BRIDGE_HAS_IDLE_TASKS
+            /* The platform is required in order to express the deadline in the V8 clock, so nothing is done without one.
+                Its pending idle tasks are run first. */
+            inline bool run_idle_tasks(Isolate *isolate, Platform *platform, double idleTimeInSeconds)
+            {
+                if (platform == NULL)
+                {
+                    return false;
+                }
+                
+                double deadline = platform->MonotonicallyIncreasingTime() + idleTimeInSeconds;
+                platform::RunIdleTasks(platform, isolate, idleTimeInSeconds);
+                
+                if (platform->MonotonicallyIncreasingTime() >= deadline)
+                {
+                    return false;
+                }
+                
+                return isolate->IdleNotificationDeadline(deadline);
+            }
+#else
+            inline bool run_idle_tasks(Isolate *isolate, double idleTimeInSeconds)
+            {
+#   if V8BRIDGE_V8_VERSION_AT_LEAST(3, 28)
+                return isolate->IdleNotification(static_cast<int>(idleTimeInSeconds * 1000));
+#   else
+                return V8::IdleNotification(static_cast<int>(idleTimeInSeconds * 1000));
+#   endif
+            }
+#endif
+        }
+    }
+}
+
+#endif
@@ -37,15 +37,20 @@
  *          };
  *          return callback->Call(callback, N, argv);
  *      }
+ *
+ *  In addition, invoke_v8_handle_many allows to apply a function over a whole native range,
+ *  converting each returned value into an output iterator.
  */
 
 #ifndef BOOST_PP_IS_ITERATING
 #   ifndef v8bridge_invoke_v8_handle_hpp
 #       define v8bridge_invoke_v8_handle_hpp
 
+#       include <sstream>
 #       include <stdexcept>
 
 #       include <v8bridge/detail/prefix.hpp>
+#       include <v8bridge/detail/typeid.hpp>
 
 #       include <v8bridge/conversion.hpp>   // Include the conversion API
 
@@ -83,6 +88,66 @@ namespace v8
             return result;
         }
         
+/* The number of elements converted by invoke_v8_handle_many before its handle scope is recycled (0 = never recycle) */
+#       ifndef V8BRIDGE_INVOKE_MANY_SCOPE_SIZE
+#           define V8BRIDGE_INVOKE_MANY_SCOPE_SIZE 1024
+#       endif
+        
+        /**
+         * Invoke the given V8 function for each element in the given native range (with type conversion).
+         * The function is called with the element as its single argument, and the converted returned values are written into the given output iterator.
+         *
+         * Unlike calling invoke_v8_handle for each element, the receiver and the arguments array are set up only once,
+         * and the handles created by each call are released in bulk once every recycleEvery elements.
+         *
+         * @param Isolate isolationScope - the used isolation scope
+         * @param Handle<Function> func - the function to invoke
+         * @param first, last - the native elements range
+         * @param out - the output iterator that receives the converted returned values
+         * @param recycleEvery - the number of elements to process in each handle scope (0 = use a single handle scope)
+         * @return TOutputIterator the output iterator, past the last written element.
+         *  If the function throws, the iteration stops and the exception is left pending in the isolation scope.
+         */
+        template <class TResult, class TInputIterator, class TOutputIterator>
+        static inline TOutputIterator invoke_v8_handle_many(Isolate *isolationScope, Handle<Function> &callback,
+                                                            TInputIterator first, TInputIterator last, TOutputIterator out,
+                                                            size_t recycleEvery = V8BRIDGE_INVOKE_MANY_SCOPE_SIZE)
+        {
+            HandleScope handle_scope(isolationScope);
+            
+            Handle<Object> receiver = callback;
+            Handle<Value> argv[1];
+            
+            while (first != last)
+            {
+                HandleScope chunk_scope(isolationScope);
+                
+                for (size_t i = 0; first != last && (recycleEvery == 0 || i < recycleEvery); ++i, ++first)
+                {
+                    argv[0] = NativeToJs(isolationScope, *first);
+                    
+                    Local<Value> returnedValue = callback->Call(receiver, 1, argv);
+                    if (returnedValue.IsEmpty())
+                    {
+                        return out;
+                    }
+                    
+                    TResult result;
+                    if (!JsToNative(isolationScope, result, returnedValue))
+                    {
+                        std::stringstream io;
+                        io << "The function returned value does not match the specified TResult (" << TypeId<TResult>().name() << ").";
+                        throw std::runtime_error(io.str());
+                    }
+                    
+                    *out = result;
+                    ++out;
+                }
+            }
+            
+            return out;
+        }
+        
 #       define BOOST_PP_ITERATION_PARAMS_1 (3, (1, V8_MAX_ARITY, <v8bridge/native/invoke_v8_handle.hpp>))
 #       include BOOST_PP_ITERATE()
     }
@@ -0,0 +1,373 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * This file contains the implementation of async native functions - native functions that are run on a worker pool
+ * and return a JS Promise, which is settled on the engine thread once the native function completes.
+ *
+ * For example - in case we wish to expose the given function:
+ *      std::string read_file(std::string path) { ... }
+ *
+ * ScriptingEngine::exposeAsync(read_file, "readFile") allows to use it from JS as:
+ *      readFile("/tmp/foo").then(function (contents) { ... });
+ *
+ * The arguments are converted on the engine thread, before the call is scheduled. The result is converted (by NativeToJs)
+ * when the promise is resolved, which is done by the engine posted tasks (see ScriptingEngine::runPending).
+ * An exception thrown by the native function rejects the promise with an Error carrying the exception message.
+ *
+ * Since the converted arguments are copied to a worker thread, the function can't receive V8 handles
+ * or native class instances (pointers to JS owned objects). Such signatures are rejected at compile time.
+ */
+
+#ifndef BOOST_PP_IS_ITERATING
+#   ifndef v8bridge_native_async_function_hpp
+#       define v8bridge_native_async_function_hpp
+
+#       include <v8bridge/detail/prefix.hpp>
+
+#       include <exception>
+#       include <boost/mpl/at.hpp>
+#       include <boost/mpl/int.hpp>
+#       include <boost/mpl/size.hpp>
+#       include <boost/shared_ptr.hpp>
+#       include <boost/static_assert.hpp>
+#       include <boost/type_traits/integral_constant.hpp>
+#       include <boost/type_traits/is_convertible.hpp>
+#       include <boost/type_traits/is_pointer.hpp>
+#       include <boost/type_traits/remove_const.hpp>
+#       include <boost/type_traits/remove_reference.hpp>
+#       include <boost/preprocessor/repetition.hpp>
+#       include <boost/preprocessor/iteration/iterate.hpp>
+
+#       include <v8bridge/async_worker_pool.hpp>
+#       include <v8bridge/conversion.hpp>
+#       include <v8bridge/native/native_endpoint.hpp>
+
+/* Promise::Resolver with the MaybeLocal based API */
+#ifndef V8BRIDGE_HAS_PROMISES
+#   define V8BRIDGE_HAS_PROMISES V8BRIDGE_V8_VERSION_AT_LEAST(6, 0)
+#endif
+
+#if V8BRIDGE_HAS_PROMISES
+
+namespace v8
+{
+    namespace bridge
+    {
+        using namespace v8;
+        
+        namespace detail
+        {
+            /**
+             * Is the given type a V8 handle (which is bound to the engine thread)?
+             */
+            template <class T>
+            struct is_v8_handle : boost::is_convertible<T, Handle<Value> > { };
+            
+            template <class T, class M>
+            struct is_v8_handle<Persistent<T, M> > : boost::true_type { };
+            
+            template <class T>
+            struct is_v8_handle<Eternal<T> > : boost::true_type { };
+            
+            /**
+             * The JS side of a pending async call: the promise resolver and the context it was created in.
+             * Should only be touched (and released) on the engine thread.
+             */
+            struct AsyncCall
+            {
+                AsyncCall(Isolate *isolate, Handle<Context> context, Handle<Promise::Resolver> resolver) :
+                isolate(isolate), context(isolate, context), resolver(isolate, resolver) { }
+                
+                inline void resolve(Handle<Value> value)
+                {
+                    Local<Context> localContext = Local<Context>::New(this->isolate, this->context);
+                    Local<Promise::Resolver>::New(this->isolate, this->resolver)->Resolve(localContext, value);
+                    this->release();
+                }
+                
+                inline void reject(const std::string &message)
+                {
+                    Local<Context> localContext = Local<Context>::New(this->isolate, this->context);
+                    Local<Value> error = Exception::Error(String::NewFromUtf8(this->isolate, message.c_str()));
+                    Local<Promise::Resolver>::New(this->isolate, this->resolver)->Reject(localContext, error);
+                    this->release();
+                }
+                
+                inline void release()
+                {
+                    this->resolver.Reset();
+                    this->context.Reset();
+                }
+                
+                Isolate *isolate;
+                Persistent<Context> context;
+                Persistent<Promise::Resolver> resolver;
+            };
+            
+            /* Posted to the engine in order to settle the promise */
+            template <class TResult, class TEngine>
+            struct AsyncResolveTask
+            {
+                AsyncResolveTask(const boost::shared_ptr<AsyncCall> &call, const TResult &result) : call(call), result(result) { }
+                
+                inline void operator()(TEngine &)
+                {
+                    HandleScope handle_scope(this->call->isolate);
+                    Context::Scope context_scope(Local<Context>::New(this->call->isolate, this->call->context));
+                    
+                    this->call->resolve(NativeToJs<TResult>(this->call->isolate, this->result));
+                }
+                
+                boost::shared_ptr<AsyncCall> call;
+                TResult result;
+            };
+            
+            template <class TEngine>
+            struct AsyncResolveTask<void, TEngine>
+            {
+                AsyncResolveTask(const boost::shared_ptr<AsyncCall> &call) : call(call) { }
+                
+                inline void operator()(TEngine &)
+                {
+                    HandleScope handle_scope(this->call->isolate);
+                    Context::Scope context_scope(Local<Context>::New(this->call->isolate, this->call->context));
+                    
+                    this->call->resolve(v8::Undefined(this->call->isolate));
+                }
+                
+                boost::shared_ptr<AsyncCall> call;
+            };
+            
+            template <class TEngine>
+            struct AsyncRejectTask
+            {
+                AsyncRejectTask(const boost::shared_ptr<AsyncCall> &call, const std::string &message) : call(call), message(message) { }
+                
+                inline void operator()(TEngine &)
+                {
+                    HandleScope handle_scope(this->call->isolate);
+                    Context::Scope context_scope(Local<Context>::New(this->call->isolate, this->call->context));
+                    
+                    this->call->reject(this->message);
+                }
+                
+                boost::shared_ptr<AsyncCall> call;
+                std::string message;
+            };
+            
+            /* Run on the worker pool. Runs the native function and posts its result back to the engine. */
+            template <class TResult, class TJob, class TEngine>
+            struct AsyncJob
+            {
+                AsyncJob(TEngine *engine, const boost::shared_ptr<AsyncCall> &call, const TJob &job) : engine(engine), call(call), job(job) { }
+                
+                inline void operator()()
+                {
+                    try
+                    {
+                        this->engine->post(AsyncResolveTask<TResult, TEngine>(this->call, this->job()));
+                    }
+                    catch (const std::exception &e)
+                    {
+                        this->engine->post(AsyncRejectTask<TEngine>(this->call, e.what()));
+                    }
+                    catch (...)
+                    {
+                        this->engine->post(AsyncRejectTask<TEngine>(this->call, "Unknown native exception."));
+                    }
+                    
+                    this->engine->endAsyncCall();
+                }
+                
+                TEngine *engine;
+                boost::shared_ptr<AsyncCall> call;
+                TJob job;
+            };
+            
+            template <class TJob, class TEngine>
+            struct AsyncJob<void, TJob, TEngine>
+            {
+                AsyncJob(TEngine *engine, const boost::shared_ptr<AsyncCall> &call, const TJob &job) : engine(engine), call(call), job(job) { }
+                
+                inline void operator()()
+                {
+                    try
+                    {
+                        this->job();
+                        this->engine->post(AsyncResolveTask<void, TEngine>(this->call));
+                    }
+                    catch (const std::exception &e)
+                    {
+                        this->engine->post(AsyncRejectTask<TEngine>(this->call, e.what()));
+                    }
+                    catch (...)
+                    {
+                        this->engine->post(AsyncRejectTask<TEngine>(this->call, "Unknown native exception."));
+                    }
+                    
+                    this->engine->endAsyncCall();
+                }
+                
+                TEngine *engine;
+                boost::shared_ptr<AsyncCall> call;
+                TJob job;
+            };
+        }
+        
+        template <class TEngine, class TFunction, class TSignature>
+        class V8_DECL NativeAsyncFunction : public NativeEndpoint
+        {
+        public:
+            typedef typename boost::mpl::at_c<TSignature, 0>::type TResult;
+            enum { arity = boost::mpl::size<TSignature>::value - 1 };
+            
+            BOOST_STATIC_ASSERT_MSG(!detail::is_v8_handle<TResult>::value, "Async functions can't return V8 handles, since they're run on a worker thread.");
+            
+            /**
+             * @param engine - the engine that owns the function, which settles the function promises (see ScriptingEngine::runPending).
+             */
+            NativeAsyncFunction(TEngine *engine, TFunction function, const boost::shared_ptr<AsyncWorkerPool> &workerPool) :
+            NativeEndpoint(engine->getActiveIsolationScope()), m_engine(engine), m_function(function), m_workerPool(workerPool)
+            {
+                HandleScope handle_scope(this->m_isolationScope);
+                Local<FunctionTemplate> templ = detail::new_endpoint_template(this->m_isolationScope, this, &NativeAsyncFunction::internalFunctionInvocationCallback);
+                
+                this->m_templateDecl = new Eternal<FunctionTemplate>(this->m_isolationScope, templ);
+            }
+            
+            ~NativeAsyncFunction()
+            {
+                delete this->m_templateDecl;
+            }
+            
+            inline Handle<FunctionTemplate> getTemplate() { return this->m_templateDecl->Get(this->m_isolationScope); }
+            
+            virtual void adoptTemplate(Local<FunctionTemplate> templ)
+            {
+                delete this->m_templateDecl;
+                this->m_templateDecl = new Eternal<FunctionTemplate>(this->m_isolationScope, templ);
+            }
+            
+            virtual void dispatch(const FunctionCallbackInfo<Value>& info)
+            {
+                this->invoke(info);
+            }
+            
+            /**
+             * Explicity invoke the async function with the given V8 function callback info
+             */
+            inline void invoke(const FunctionCallbackInfo<Value>& info)
+            {
+                HandleScope handle_scope(info.GetIsolate());
+                
+                if (info.Length() != arity)
+                {
+                    this->throwException(info, "MissingFunctionException. The async function arity does not match the number of provided arguments.");
+                    return;
+                }
+                
+                this->forwardInvoke(info, boost::mpl::int_<arity>());
+            }
+        protected:
+            mutable Eternal<FunctionTemplate> *m_templateDecl;
+            TEngine *m_engine;
+            TFunction m_function;
+            boost::shared_ptr<AsyncWorkerPool> m_workerPool;
+            
+            template <int TIndex>
+            struct arg_type
+            {
+                typedef typename boost::remove_const<
+                    typename boost::remove_reference<typename boost::mpl::at_c<TSignature, TIndex + 1>::type>::type
+                >::type type;
+                
+                /* The arguments are copied to the worker thread, in which V8 handles and JS owned native instances can't be used */
+                BOOST_STATIC_ASSERT_MSG(!detail::is_v8_handle<type>::value, "Async functions can't receive V8 handles, since they're run on a worker thread.");
+                BOOST_STATIC_ASSERT_MSG(!boost::is_pointer<type>::value, "Async functions can't receive pointers (e.g. native class instances), since they're run on a worker thread.");
+            };
+            
+            inline void throwException(const FunctionCallbackInfo<Value>& info, const char *message)
+            {
+                info.GetIsolate()->ThrowException(v8::Exception::TypeError(String::NewFromUtf8(info.GetIsolate(), message)));
+            }
+            
+            /* Create the promise and schedule the given job (the native function bound to the converted arguments) */
+            template <class TJob>
+            inline void schedule(const FunctionCallbackInfo<Value>& info, const TJob &job)
+            {
+                Isolate *isolate = info.GetIsolate();
+                Local<Context> context = isolate->GetCurrentContext();
+                Local<Promise::Resolver> resolver = Promise::Resolver::New(context).ToLocalChecked();
+                
+                boost::shared_ptr<detail::AsyncCall> call(new detail::AsyncCall(isolate, context, resolver));
+                
+                this->m_engine->beginAsyncCall();
+                this->m_workerPool->submit(detail::AsyncJob<TResult, TJob, TEngine>(this->m_engine, call, job));
+                
+                info.GetReturnValue().Set(resolver->GetPromise());
+            }
+            
+#       define BOOST_PP_ITERATION_PARAMS_1 (3, (0, V8_MAX_ARITY, <v8bridge/native/native_async_function.hpp>))
+#       include BOOST_PP_ITERATE()
+            
+            inline static void internalFunctionInvocationCallback(const FunctionCallbackInfo<Value>& info)
+            {
+                NativeAsyncFunction *instance = static_cast<NativeAsyncFunction *>(External::Cast(*info.Data())->Value());
+                instance->dispatch(info);
+            }
+        };
+    }
+}
+
+#endif // V8BRIDGE_HAS_PROMISES
+
+#   endif // v8bridge_native_async_function_hpp
+#else // BOOST_PP_IS_ITERATING
+#   if BOOST_PP_ITERATION_DEPTH() == 1 // defined(BOOST_PP_IS_ITERATING)
+#       define N BOOST_PP_ITERATION()
+#       define V8_BRIDGE_ASYNC_CONVERT_ARG(z, n, data)                                                   \
+            typename arg_type<n>::type BOOST_PP_CAT(arg, n);                                            \
+            if (!JsToNative(info.GetIsolate(), BOOST_PP_CAT(arg, n), info[n]))                          \
+            {                                                                                           \
+                this->throwException(info, "TypeError. The provided argument does not match the async function argument type."); \
+                return;                                                                                 \
+            }
+
+/* f(arg0...argN) */
+inline void forwardInvoke(const FunctionCallbackInfo<Value>& info, boost::mpl::int_<N>)
+{
+    BOOST_PP_REPEAT(N, V8_BRIDGE_ASYNC_CONVERT_ARG, ~)
+    
+    TFunction function = this->m_function;
+    this->schedule(info, [=]() mutable { return function(BOOST_PP_ENUM_PARAMS(N, arg)); });
+}
+
+#       undef V8_BRIDGE_ASYNC_CONVERT_ARG
+#       undef N
+#   endif // BOOST_PP_ITERATION_DEPTH
+#endif
@@ -38,7 +38,7 @@
  *          struct impl
  *          {
  *          public:
- *              impl(Isolate *isolate, TPointer p);
+ *              impl(Isolate *isolate, TPointer &p);
  *
  *              // Gets the number arity for the given specific implementation
  *              static unsigned getArity() { return N; }
@@ -135,7 +135,7 @@ namespace v8
             typedef typename caller_base_select<TPointer, TSignature>::type base;
             typedef Handle<Value> result_type;
             
-            caller(Isolate *isolate, TPointer pointer) : base(isolate, pointer) { };
+            caller(Isolate *isolate, TPointer &pointer) : base(isolate, pointer) { };
         };
     }
 }
@@ -150,7 +150,7 @@ struct caller_arity<N>
     struct impl
     {
     public:
-        impl(Isolate *isolate, TPointer p) : m_callbackPointer(p), m_isolationScope(isolate) { };
+        impl(Isolate *isolate, TPointer &p) : m_callbackPointer(p), m_isolationScope(isolate) { };
         
         inline static unsigned getArity() { return N; }
         
@@ -323,7 +323,10 @@ I'm leaving this in operator() too only for debugging preposes. */
         }
     private:
         Isolate *m_isolationScope;
-        TPointer m_callbackPointer;
+        
+        /* The callback is owned by the concrete endpoint (NativeFunctionConcrete etc.), so we're only referencing it.
+            This avoids copying stateful callables (lambdas, functors) on every call. */
+        TPointer &m_callbackPointer;
     };
 };
 
@@ -84,15 +84,16 @@ namespace v8
             m_accessors(new TMethodsMap()),
             m_staticAccessors(new TMethodsMap()),
             m_gc(new GC(isolationScope)),
+            m_instanceHandles(new TInstanceHandlesMap()),
             m_customDtorHandler(NULL)
             {
                 HandleScope handle_scope(isolationScope);
                 
                 this->m_isAbstract = false;
-                Local<FunctionTemplate> templ = FunctionTemplate::New(
+                Local<FunctionTemplate> templ = detail::new_endpoint_template(
                                                                       /* isolate: */this->m_isolationScope,
-                                                                      /* callback (used as constructor) */ &NativeClass<TClass>::internalConstructorInvocationCallback,
-                                                                      /* data: */External::New(isolationScope, (void *)this));
+                                                                      /* endpoint (passed as data): */this,
+                                                                      /* callback (used as constructor) */ &NativeClass<TClass>::internalConstructorInvocationCallback);
                 
                 this->m_templateDecl = new Eternal<FunctionTemplate>(this->m_isolationScope, templ);
                 this->setInternalFieldsCount(0);
@@ -143,6 +144,8 @@ namespace v8
                 delete this->m_staticAccessors;
                 
                 /* GC */
+                this->releaseInstances();
+                delete this->m_instanceHandles;
                 delete this->m_gc;
                 
                 /* Ctor */
@@ -158,6 +161,127 @@ namespace v8
              */
             inline Handle<FunctionTemplate> getTemplate() { return this->m_templateDecl->Get(this->m_isolationScope); }
             
+            virtual void adoptTemplate(Local<FunctionTemplate> templ)
+            {
+                delete this->m_templateDecl;
+                this->m_templateDecl = new Eternal<FunctionTemplate>(this->m_isolationScope, templ);
+            }
+            
+            /**
+             * Handle a call of the class constructor.
+             */
+            virtual void dispatch(const FunctionCallbackInfo<Value>& info)
+            {
+                using namespace boost;
+                
+                NativeClass<TClass> *self = this;
+                
+                EscapableHandleScope handle_scope(self->m_isolationScope);
+                
+                //-------------------------------------------------
+                //  Firstly, make sure that this class wasn't marked as abstract
+                //-------------------------------------------------
+                
+                if (self->m_isAbstract)
+                {
+                    std::stringstream io;
+                    io << "Could not create an instance of the class " << TypeId<typename TypeResolver<TClass>::type >().name() << " since it was marked as abstract class." << std::endl;
+#if V8BRIDGE_DEBUG
+                    io << "In order to allow the class instantiation, you should call the NativeClass<TClass>::declareAsAbstract with false argument.";
+#endif
+                    self->m_isolationScope->ThrowException(
+                                                           v8::Exception::TypeError(String::NewFromUtf8(self->m_isolationScope, io.str().c_str()))
+                    );
+                    return;
+                }
+                
+                //-------------------------------------------------
+                //  We got two cases to deal with.
+                //      - The first one is in which we're trying to instansiate plain new object (e.g. from JS)
+                //          In this case, we should allocate a new coresponding CPP object (i.e. "var p = new Point(x, y);" in JS will allocate new CPP Point).
+                //      - The second one is case in which we're trying to Convert Existing CPP Object to JS (i.e. by using NativeToJs interface).
+                //          in this case we still should create a new JS object, but We Shouldn't Allocate a new CPP object but using the Existing one.
+                //
+                //  As a result, we can't forward the constructor directly to the CPP ctor but create a constructor that discrimiate between these cases.
+                //  The solution that came up is to pass the native instance as an External value when using NativeToJs. Here, we should check whether or not we've recevived as ctor args only 1 arg of type External.
+                //  if so, this is NativeToJs. Otherwise - we're dealing with new instansiation.
+                //
+                //  For more details, see: http://create.tpsitulsa.com/blog/2009/01/29/v8-objects/
+                //-------------------------------------------------
+                External *externalInstance;
+                TClass *instance;
+                if (!info[0]->IsExternal())
+                {
+                    //-------------------------------------------------
+                    //  Do we got at least one constructor?
+                    //  If not, we shall use a default one
+                    //-------------------------------------------------
+                    
+                    if (self->m_ctor->getOverloadsCount() < 1)
+                    {
+                        /* There's no constructor, so just create the object */
+                        try
+                        {
+                            instance = new TClass();
+                        }
+                        catch (...)
+                        {
+                            delete instance;
+                            throw;
+                        }
+                        
+                        /* Save the binded C++ instance in the new created JS object */
+                        info.This()->SetAlignedPointerInInternalField(info.This()->InternalFieldCount() - 2, (void *)instance);
+                    }
+                    else
+                    {
+                        /* Invoke the actual class constructor */
+                        self->m_ctor->invoke(info);
+                    
+                        /* Get the TClass instance */
+                        instance = (TClass *)info.This()->GetAlignedPointerFromInternalField(info.This()->InternalFieldCount() - 2);
+                    }
+                }
+                else
+                {
+                    /* Get the v8::External instance */
+                    externalInstance = External::Cast(*info[0]);
+                    
+                    /* Get the TClass instance */
+                    instance = (TClass *)externalInstance->Value();
+                }
+                
+                /* Save the TClass instance in the new created JS object */
+                info.This()->SetAlignedPointerInInternalField(info.This()->InternalFieldCount() - 2, (void *)instance);
+                
+                /* Basic memory adjustment */
+                self->m_isolationScope->AdjustAmountOfExternalAllocatedMemory(self->m_allocatedMemoryAdjustment);
+               
+                /* Save an pointer to "this" (self variable) since
+                    we can't access it in the SetWeak() callback. */
+                info.This()->SetAlignedPointerInInternalField(info.This()->InternalFieldCount() - 1, (void *)self);
+                
+                /* Create persistent object so we can make this object accessable outside the handle-scope ?*/
+                v8::Persistent<v8::Object> *handle = new v8::Persistent<v8::Object>(self->m_isolationScope, info.This());
+                
+                /* Setup weak connection */
+                handle->SetWeak(instance, &NativeClass<TClass>::WeakObjectsDeletionCallback);
+                handle->MarkIndependent();
+                
+                /* Keep track of the handle, so it can be detached when the instances are released */
+                (*self->m_instanceHandles)[(void *)instance] = handle;
+                
+                /* Expose to the class GC */
+                if (self->m_customDtorHandler == NULL)
+                {
+                    self->m_gc->queue(instance); // we can not send null, otherwise even the default dtor wont be run, thus, the object won't be released.
+                }
+                else
+                {
+                    self->m_gc->queue(instance, self->m_customDtorHandler);
+                }
+            }
+            
             /**
              * Test if a given handle is an instance of this class.
              */
@@ -601,20 +725,29 @@ namespace v8
             inline NativeClass<TClass> *disposeInstance(Handle<Object> handle)
             {
                 v8::HandleScope handle_scope(this->m_isolationScope);
-                Persistent<Object> p(this->m_isolationScope, handle);
                 
                 void* ptr = handle->GetAlignedPointerFromInternalField(handle->InternalFieldCount() - 2);
                 
-                this->m_gc->disposeAndDequeue(ptr);
+                bool disposed = this->m_gc->disposeAndDequeue(ptr);
                 
                 for (int i = 0; i < handle->InternalFieldCount(); i++)
                 {
                     handle->SetAlignedPointerInInternalField(i, NULL);
                 }
-                p.Reset();
                 
-                /* Memory adjustment */
-                this->m_isolationScope->AdjustAmountOfExternalAllocatedMemory(this->m_allocatedMemoryAdjustment * -1);
+                TInstanceHandlesMap::iterator it = this->m_instanceHandles->find(ptr);
+                if (it != this->m_instanceHandles->end())
+                {
+                    it->second->Reset();
+                    delete it->second;
+                    this->m_instanceHandles->erase(it);
+                }
+                
+                /* Memory adjustment (instances released by releaseInstances were already accounted) */
+                if (disposed)
+                {
+                    this->m_isolationScope->AdjustAmountOfExternalAllocatedMemory(this->m_allocatedMemoryAdjustment * -1);
+                }
                 
                 return this;
             }
@@ -629,6 +762,70 @@ namespace v8
             }
             
             
+            /**
+             * Free all the C++ instances that are still bound to JS objects of this class.
+             *
+             * You may call this method only, and ONLY, when the JS objects are no longer reachable by scripts
+             * (e.g. when the class is destroyed).
+             */
+            inline void releaseInstances()
+            {
+                /* Detach the JS objects first, so their weak callbacks won't fire for the released instances */
+                if (!this->m_instanceHandles->empty())
+                {
+                    HandleScope handle_scope(this->m_isolationScope);
+                    
+                    for (TInstanceHandlesMap::iterator it = this->m_instanceHandles->begin(); it != this->m_instanceHandles->end(); ++it)
+                    {
+                        this->detachInstanceHandle(it->second);
+                    }
+                    
+                    this->m_instanceHandles->clear();
+                }
+                
+                int64_t released = static_cast<int64_t>(this->m_gc->size());
+                this->m_gc->collect();
+                
+                /* Memory adjustment */
+                this->m_isolationScope->AdjustAmountOfExternalAllocatedMemory(-released * static_cast<int64_t>(this->m_allocatedMemoryAdjustment));
+            }
+            
+            /**
+             * Free the C++ instances that are bound to JS objects of this class, which were created in the given context.
+             * The instances of the other contexts are kept.
+             *
+             * You may call this method only, and ONLY, when the JS objects of the given context are no longer reachable by scripts
+             * (e.g. when the context was discarded). See ScriptingEngine::reset and ScriptingEngine::releaseContext.
+             */
+            virtual void releaseInstances(Handle<Context> context)
+            {
+                HandleScope handle_scope(this->m_isolationScope);
+                int64_t released = 0;
+                
+                for (TInstanceHandlesMap::iterator it = this->m_instanceHandles->begin(); it != this->m_instanceHandles->end(); )
+                {
+                    /* The object creation context is the context in which the instance was bound (see dispatch and wrap) */
+                    if (Local<Object>::New(this->m_isolationScope, *it->second)->CreationContext() != context)
+                    {
+                        ++it;
+                        continue;
+                    }
+                    
+                    /* Detach the JS object first, so its weak callback won't fire for the released instance */
+                    this->detachInstanceHandle(it->second);
+                    
+                    if (this->m_gc->disposeAndDequeue(it->first))
+                    {
+                        ++released;
+                    }
+                    
+                    this->m_instanceHandles->erase(it++);
+                }
+                
+                /* Memory adjustment */
+                this->m_isolationScope->AdjustAmountOfExternalAllocatedMemory(-released * static_cast<int64_t>(this->m_allocatedMemoryAdjustment));
+            }
+            
             /**
              * Static callback used with Persistent<T>.SetWeak in order to
              * delete references.
@@ -646,6 +843,7 @@ namespace v8
         private:
             typedef std::list<boost::shared_ptr<NativeFunction> > TMethodsList;
             typedef std::map<std::string, boost::shared_ptr<NativeFunction> > TMethodsMap;
+            typedef std::map<void *, Persistent<Object> *> TInstanceHandlesMap;
             
             NativeCtor *m_ctor;
             
@@ -661,115 +859,28 @@ namespace v8
             
             size_t m_allocatedMemoryAdjustment = sizeof(TClass);
             GC *m_gc;
+            TInstanceHandlesMap *m_instanceHandles; // The weak handles of the JS objects bound to native instances
             GC::TDtor m_customDtorHandler;
             
-            inline static void internalConstructorInvocationCallback(const FunctionCallbackInfo<Value>& info)
+            /**
+             * Clear the internal fields of the given bound JS object and free its (weak) handle.
+             */
+            inline void detachInstanceHandle(Persistent<Object> *handle)
             {
-                using namespace boost;
-                
-                NativeClass<TClass> *self = static_cast<NativeClass<TClass> *>(External::Cast(*info.Data())->Value());
-                
-                EscapableHandleScope handle_scope(self->m_isolationScope);
-                
-                //-------------------------------------------------
-                //  Firstly, make sure that this class wasn't marked as abstract
-                //-------------------------------------------------
-                
-                if (self->m_isAbstract)
+                Local<Object> object = Local<Object>::New(this->m_isolationScope, *handle);
+                for (int i = 0; i < object->InternalFieldCount(); i++)
                 {
-                    std::stringstream io;
-                    io << "Could not create an instance of the class " << TypeId<typename TypeResolver<TClass>::type >().name() << " since it was marked as abstract class." << std::endl;
-#if V8BRIDGE_DEBUG
-                    io << "In order to allow the class instantiation, you should call the NativeClass<TClass>::declareAsAbstract with false argument.";
-#endif
-                    self->m_isolationScope->ThrowException(
-                                                           v8::Exception::TypeError(String::NewFromUtf8(self->m_isolationScope, io.str().c_str()))
-                    );
-                    return;
+                    object->SetAlignedPointerInInternalField(i, NULL);
                 }
                 
-                //-------------------------------------------------
-                //  We got two cases to deal with.
-                //      - The first one is in which we're trying to instansiate plain new object (e.g. from JS)
-                //          In this case, we should allocate a new coresponding CPP object (i.e. "var p = new Point(x, y);" in JS will allocate new CPP Point).
-                //      - The second one is case in which we're trying to Convert Existing CPP Object to JS (i.e. by using NativeToJs interface).
-                //          in this case we still should create a new JS object, but We Shouldn't Allocate a new CPP object but using the Existing one.
-                //
-                //  As a result, we can't forward the constructor directly to the CPP ctor but create a constructor that discrimiate between these cases.
-                //  The solution that came up is to pass the native instance as an External value when using NativeToJs. Here, we should check whether or not we've recevived as ctor args only 1 arg of type External.
-                //  if so, this is NativeToJs. Otherwise - we're dealing with new instansiation.
-                //
-                //  For more details, see: http://create.tpsitulsa.com/blog/2009/01/29/v8-objects/
-                //-------------------------------------------------
-                External *externalInstance;
-                TClass *instance;
-                if (!info[0]->IsExternal())
-                {
-                    //-------------------------------------------------
-                    //  Do we got at least one constructor?
-                    //  If not, we shall use a default one
-                    //-------------------------------------------------
-                    
-                    if (self->m_ctor->getOverloadsCount() < 1)
-                    {
-                        /* There's no constructor, so just create the object */
-                        try
-                        {
-                            instance = new TClass();
-                        }
-                        catch (...)
-                        {
-                            delete instance;
-                            throw;
-                        }
-                        
-                        /* Save the binded C++ instance in the new created JS object */
-                        info.This()->SetAlignedPointerInInternalField(info.This()->InternalFieldCount() - 2, (void *)instance);
-                    }
-                    else
-                    {
-                        /* Invoke the actual class constructor */
-                        self->m_ctor->invoke(info);
-                    
-                        /* Get the TClass instance */
-                        instance = (TClass *)info.This()->GetAlignedPointerFromInternalField(info.This()->InternalFieldCount() - 2);
-                    }
-                }
-                else
-                {
-                    /* Get the v8::External instance */
-                    externalInstance = External::Cast(*info[0]);
-                    
-                    /* Get the TClass instance */
-                    instance = (TClass *)externalInstance->Value();
-                }
-                
-                /* Save the TClass instance in the new created JS object */
-                info.This()->SetAlignedPointerInInternalField(info.This()->InternalFieldCount() - 2, (void *)instance);
-                
-                /* Basic memory adjustment */
-                self->m_isolationScope->AdjustAmountOfExternalAllocatedMemory(self->m_allocatedMemoryAdjustment);
-               
-                /* Save an pointer to "this" (self variable) since
-                    we can't access it in the SetWeak() callback. */
-                info.This()->SetAlignedPointerInInternalField(info.This()->InternalFieldCount() - 1, (void *)self);
-                
-                /* Create persistent object so we can make this object accessable outside the handle-scope ?*/
-                v8::Persistent<v8::Object> handle(self->m_isolationScope, info.This());
-                
-                /* Setup weak connection */
-                handle.SetWeak(instance, &NativeClass<TClass>::WeakObjectsDeletionCallback);
-                handle.MarkIndependent();
-                
-                /* Expose to the class GC */
-                if (self->m_customDtorHandler == NULL)
-                {
-                    self->m_gc->queue(instance); // we can not send null, otherwise even the default dtor wont be run, thus, the object won't be released.
-                }
-                else
-                {
-                    self->m_gc->queue(instance, self->m_customDtorHandler);
-                }
+                handle->Reset();
+                delete handle;
+            }
+            
+            inline static void internalConstructorInvocationCallback(const FunctionCallbackInfo<Value>& info)
+            {
+                NativeClass<TClass> *self = static_cast<NativeClass<TClass> *>(External::Cast(*info.Data())->Value());
+                self->dispatch(info);
             }
             
             //=======================================================================
@@ -34,19 +34,75 @@
 #include <boost/mpl/vector.hpp>
 #include <boost/mpl/at.hpp>
 
+/* The isolation scope data slot used to store the endpoints router (see SnapshotBindings) */
+#ifndef V8BRIDGE_ENDPOINT_ROUTER_DATA_SLOT
+#   define V8BRIDGE_ENDPOINT_ROUTER_DATA_SLOT 1
+#endif
+
 namespace v8
 {
     namespace bridge
     {
         using namespace v8;
         
+        class NativeEndpoint;
+        
+        namespace detail
+        {
+            /**
+             * Creates the endpoints templates of an isolation scope, instead of binding them directly to the endpoints addresses.
+             * See SnapshotBindings, which routes the templates calls through registered slots so the templates can be serialized.
+             */
+            class V8_DECL EndpointRouter
+            {
+            public:
+                virtual ~EndpointRouter() { }
+                virtual Local<FunctionTemplate> newTemplate(NativeEndpoint *endpoint) = 0;
+            };
+            
+            /**
+             * Create the JS function template of the given endpoint. By default, the template calls the given callback
+             * with the endpoint address (as an External) as its data. When the isolation scope got an endpoint router,
+             * the router creates the template (and the endpoint is called through NativeEndpoint::dispatch).
+             */
+            inline Local<FunctionTemplate> new_endpoint_template(Isolate *isolationScope, NativeEndpoint *endpoint, FunctionCallback callback)
+            {
+                EndpointRouter *router = static_cast<EndpointRouter *>(isolationScope->GetData(V8BRIDGE_ENDPOINT_ROUTER_DATA_SLOT));
+                if (router != NULL)
+                {
+                    return router->newTemplate(endpoint);
+                }
+                
+                return FunctionTemplate::New(isolationScope, callback, External::New(isolationScope, endpoint));
+            }
+        }
+        
         /**
          * A native-endpoint abstraction class
          */
         class V8_DECL NativeEndpoint
         {
         public:
+            virtual ~NativeEndpoint() { }
+            
             inline Isolate *getIsolationScope() { return this->m_isolationScope; }
+            
+            /**
+             * Release the native instances that were bound by this endpoint to JS objects of the given context.
+             * Called by ScriptingEngine::reset and ScriptingEngine::releaseContext, once the JS objects of the context are no longer reachable.
+             */
+            virtual void releaseInstances(Handle<Context> context) { }
+            
+            /**
+             * Handle a call of the endpoint JS function (see detail::new_endpoint_template).
+             */
+            virtual void dispatch(const FunctionCallbackInfo<Value>& info) { }
+            
+            /**
+             * Replace the endpoint template with the given (equivalent) template, e.g. one that was deserialized
+             * from a startup snapshot (see SnapshotBindings::restore).
+             */
+            virtual void adoptTemplate(Local<FunctionTemplate> templ) { }
         protected:
             NativeEndpoint(Isolate *isolationScope) : m_isolationScope(isolationScope) { }
             Isolate *m_isolationScope;
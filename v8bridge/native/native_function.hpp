@@ -34,11 +34,14 @@
 #include <boost/mpl/if.hpp>
 #include <boost/mpl/vector.hpp>
 #include <boost/mpl/at.hpp>
+#include <boost/type_traits/is_class.hpp>
+#include <boost/utility/enable_if.hpp>
 
 #include <v8bridge/detail/signature.hpp>
 #include <v8bridge/detail/signature_formatting.hpp>
 #include <v8bridge/native/native_endpoint.hpp>
 #include <v8bridge/native/native_function_concrete.hpp>
+#include <v8bridge/native/native_vectorized_function.hpp>
 
 namespace v8
 {
@@ -47,14 +50,10 @@ namespace v8
         class V8_DECL NativeFunction : public NativeEndpoint
         {
         public:
-            NativeFunction(Isolate *isolationScope) : NativeEndpoint(isolationScope), m_overloads(new TOverloadsList())
+            NativeFunction(Isolate *isolationScope) : NativeEndpoint(isolationScope), m_overloads(new TOverloadsList()), m_vectorizedVariants(new TVectorizedVariantsList())
             {
                 HandleScope handle_scope(isolationScope);
-                Local<FunctionTemplate> templ = FunctionTemplate::New(
-                                                                       this->m_isolationScope,
-                                                                       &NativeFunction::internalFunctionInvocationCallback,
-                                                                       External::New(this->m_isolationScope, this)
-                                                                       );
+                Local<FunctionTemplate> templ = detail::new_endpoint_template(this->m_isolationScope, this, &NativeFunction::internalFunctionInvocationCallback);
                 
                 this->m_templateDecl = new Eternal<FunctionTemplate>(this->m_isolationScope, templ);
                 
@@ -68,18 +67,50 @@ namespace v8
                 }
                 
                 delete this->m_overloads;
+                delete this->m_vectorizedVariants;
                 delete this->m_templateDecl;
             }
             
             inline Handle<FunctionTemplate> getTemplate() { return this->m_templateDecl->Get(this->m_isolationScope); }
             
+            virtual void adoptTemplate(Local<FunctionTemplate> templ)
+            {
+                delete this->m_templateDecl;
+                this->m_templateDecl = new Eternal<FunctionTemplate>(this->m_isolationScope, templ);
+            }
+            
+            virtual void dispatch(const FunctionCallbackInfo<Value>& info)
+            {
+                //-------------------------------------------------
+                //  Setup
+                //-------------------------------------------------
+                
+                EscapableHandleScope handle_scope(info.GetIsolate());
+                Handle<Context> context = info.GetIsolate()->GetCurrentContext();
+                Context::Scope context_scope(context);
+                
+                this->invoke(info);
+            }
+            
             /* Standard function pointer */
             template <typename TFunction>
-            inline NativeFunction *addOverload(TFunction functionPointer)
+            inline typename boost::disable_if<boost::is_class<TFunction>, NativeFunction *>::type
+            addOverload(TFunction functionPointer)
             {
                 return this->addOverload(functionPointer, get_signature(functionPointer));
             }
             
+            /**
+             * Callable object (lambda, functor, std::function etc.).
+             * The callable is stored (with its captured state) inside the overload itself and its signature is deduced from its operator().
+             */
+            template <typename TCallable>
+            inline typename boost::enable_if<boost::is_class<TCallable>, NativeFunction *>::type
+            addOverload(TCallable callable)
+            {
+                return this->addOverload(callable, get_callable_signature(callable));
+            }
+            
             /**
              * Adds overload to the given NativeFunction JS endpoint.
              * @param functionPointer - A pointer to the function that should be executed
@@ -96,6 +127,40 @@ namespace v8
                 return this;
             }
             
+            /**
+             * Exposes a vectorized variant of the given scalar function (e.g. double f(double) or int f(int, int))
+             * as a property of the JS function (by default - f.map(Float64Array[, Float64Array]) -> Float64Array).
+             * The variant runs the function over the typed arrays elements in a single native loop.
+             *
+             * Note that the variant should be exposed before the function is exposed to the engine.
+             */
+            template <typename TFunction>
+            inline typename boost::disable_if<boost::is_class<TFunction>, NativeFunction *>::type
+            exposeVectorized(TFunction functionPointer, const char *propertyName = "map")
+            {
+                return this->exposeVectorized(functionPointer, get_signature(functionPointer), propertyName);
+            }
+            
+            template <typename TCallable>
+            inline typename boost::enable_if<boost::is_class<TCallable>, NativeFunction *>::type
+            exposeVectorized(TCallable callable, const char *propertyName = "map")
+            {
+                return this->exposeVectorized(callable, get_callable_signature(callable), propertyName);
+            }
+            
+            template <class TFunction, class TSignature>
+            inline NativeFunction *exposeVectorized(TFunction functionPointer, TSignature signature, const char *propertyName = "map")
+            {
+                HandleScope handle_scope(this->m_isolationScope);
+                
+                NativeVectorizedFunction<TFunction, TSignature> *variant = new NativeVectorizedFunction<TFunction, TSignature>(this->m_isolationScope, functionPointer);
+                this->m_vectorizedVariants->push_back(boost::shared_ptr<NativeEndpoint>(variant));
+                
+                this->getTemplate()->Set(String::NewFromUtf8(this->m_isolationScope, propertyName), variant->getTemplate());
+                
+                return this;
+            }
+            
             /**
              * Get the number of registered overloads
              */
@@ -112,24 +177,28 @@ namespace v8
                 // Iterate over the registered overloads and try to find an invokable function
                 //-------------------------------------------------
                 
-                typedef std::list<NativeFunctionConcreteBase *> TConcreteOverloads;
-                TConcreteOverloads *candidates = new TConcreteOverloads();
+                /* We only need to track up to two candidates (see below), so we can keep them on the stack */
+                NativeFunctionConcreteBase *candidates[2] = { NULL, NULL };
+                size_t candidatesCount = 0;
                 
                 for (TOverloadsList::iterator iter = this->m_overloads->begin(); iter != this->m_overloads->end(); ++iter)
                 {
                     if (iter->get()->canInvokeCall(info))
                     {
-                        candidates->push_back(iter->get());
+                        if (candidatesCount < 2)
+                        {
+                            candidates[candidatesCount] = iter->get();
+                        }
+                        
+                        ++candidatesCount;
                     }
                 }
                 
-                //std::cout << "* Candidate count: " << candidates->size() << std::endl;
-                
                 //-------------------------------------------------
                 //  We couldn't find any method?
                 //-------------------------------------------------
                 
-                if (candidates->size() == 0)
+                if (candidatesCount == 0)
                 {
                     std::stringstream io;
                     io << "MissingFunctionException. No overload that matches the number and/or types of provided arguments could be found." << std::endl << "Available overloads:" << std::endl;
@@ -152,7 +221,6 @@ namespace v8
                                                       String::NewFromUtf8(info.GetIsolate(), io.str().c_str())
                                                       );
                     
-                    delete candidates;
                     return;
                 }
                 
@@ -163,15 +231,16 @@ namespace v8
                 //  In this case, we should fire the non-direct args function
                 //-------------------------------------------------
                 
-                if (candidates->size() == 2)
+                if (candidatesCount == 2)
                 {
-                    if ((*(candidates->begin()))->isDirectArgsFunction())
+                    if (candidates[0]->isDirectArgsFunction())
                     {
-                        candidates->pop_front();
+                        candidates[0] = candidates[1];
+                        candidatesCount = 1;
                     }
-                    else if ((*(candidates->back())).isDirectArgsFunction())
+                    else if (candidates[1]->isDirectArgsFunction())
                     {
-                        candidates->pop_back();
+                        candidatesCount = 1;
                     }
                 }
                 
@@ -179,22 +248,25 @@ namespace v8
                 //  Got more than one method to invoke (ambiguous call)?
                 //-------------------------------------------------
                 
-                if (candidates->size() > 1)
+                if (candidatesCount > 1)
                 {
                     std::stringstream io;
                     io << "AmbiguousMatchException. An ambiguous function call detected for the provided arguments."
                     << std::endl << "Available candidates:" << std::endl;
                     
-                    for (TConcreteOverloads::iterator iter = candidates->begin(); iter != candidates->end(); ++iter)
+                    /* Re-collect the candidates, since we only kept the first two of them */
+                    for (TOverloadsList::iterator iter = this->m_overloads->begin(); iter != this->m_overloads->end(); ++iter)
                     {
-                        io << "\t* " << (*iter)->getFormattedSignature() << std::endl;
+                        if (iter->get()->canInvokeCall(info))
+                        {
+                            io << "\t* " << iter->get()->getFormattedSignature() << std::endl;
+                        }
                     }
                     
                     info.GetIsolate()->ThrowException(
                                                       String::NewFromUtf8(info.GetIsolate(), io.str().c_str())
                                                       );
                     
-                    delete candidates;
                     return;
                 }
                 
@@ -202,9 +274,7 @@ namespace v8
                 //  Invoke
                 //-------------------------------------------------
                 
-                (*(candidates->begin()))->invokeCall(info);
-                
-                delete candidates;
+                candidates[0]->invokeCall(info);
             }
         protected:
             mutable Eternal<FunctionTemplate> *m_templateDecl;
@@ -212,6 +282,9 @@ namespace v8
             
             TOverloadsList *m_overloads;
             
+            typedef std::list<boost::shared_ptr<NativeEndpoint> > TVectorizedVariantsList;
+            TVectorizedVariantsList *m_vectorizedVariants;
+            
             /**
              * General static method used to parse incomming method invocation calls
              * and forward them to the right callback.
@@ -220,20 +293,12 @@ namespace v8
              */
             inline static void internalFunctionInvocationCallback(const FunctionCallbackInfo<Value>& info)
             {
-                //-------------------------------------------------
-                //  Setup
-                //-------------------------------------------------
-                
-                EscapableHandleScope handle_scope(info.GetIsolate());
-                Handle<Context> context = info.GetIsolate()->GetCurrentContext();
-                Context::Scope context_scope(context);
-                
                 //-------------------------------------------------
                 //  Restore the calling instance
                 //-------------------------------------------------
                 
                 NativeFunction *instance = static_cast<NativeFunction *>(External::Cast(*info.Data())->Value());
-                instance->invoke(info);
+                instance->dispatch(info);
             }
         };
     }
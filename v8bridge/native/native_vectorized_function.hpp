@@ -0,0 +1,216 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * This file contains the implementation of vectorized (typed-array) variants of scalar native functions.
+ *
+ * For example - in case we wish to expose the given function:
+ *      double square(double x) { return x * x; }
+ *
+ * NativeFunction::exposeVectorized allows to expose it as square.map(Float64Array) -> Float64Array.
+ * The C++ loop runs directly over the typed arrays backing stores, so there's a single JS-to-native call per array
+ * instead of a call per element.
+ *
+ * Note that callables (lambdas, functors) are invoked through their static type, so the compiler can inline
+ * (and usually auto-vectorize) them into the loop, while plain function pointers are invoked indirectly.
+ */
+
+#ifndef v8bridge_native_vectorized_function_hpp
+#define v8bridge_native_vectorized_function_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <boost/mpl/at.hpp>
+#include <boost/mpl/int.hpp>
+#include <boost/mpl/size.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/remove_const.hpp>
+#include <boost/type_traits/remove_reference.hpp>
+
+#include <v8bridge/detail/typed_array.hpp>
+#include <v8bridge/native/native_endpoint.hpp>
+
+namespace v8
+{
+    namespace bridge
+    {
+        using namespace v8;
+        
+        template <class TFunction, class TSignature>
+        class V8_DECL NativeVectorizedFunction : public NativeEndpoint
+        {
+        public:
+            typedef typename boost::mpl::at_c<TSignature, 0>::type TResult;
+            enum { arity = boost::mpl::size<TSignature>::value - 1 };
+            
+            BOOST_STATIC_ASSERT_MSG(arity == 1 || arity == 2, "Only unary and binary functions can be vectorized.");
+            BOOST_STATIC_ASSERT_MSG(detail::TypedArrayTraits<TResult>::isSupported, "The function return type has no matching typed array.");
+            
+            NativeVectorizedFunction(Isolate *isolationScope, TFunction function) : NativeEndpoint(isolationScope), m_function(function)
+            {
+                HandleScope handle_scope(isolationScope);
+                Local<FunctionTemplate> templ = detail::new_endpoint_template(this->m_isolationScope, this, &NativeVectorizedFunction::internalFunctionInvocationCallback);
+                
+                this->m_templateDecl = new Eternal<FunctionTemplate>(this->m_isolationScope, templ);
+            }
+            
+            ~NativeVectorizedFunction()
+            {
+                delete this->m_templateDecl;
+            }
+            
+            inline Handle<FunctionTemplate> getTemplate() { return this->m_templateDecl->Get(this->m_isolationScope); }
+            
+            virtual void adoptTemplate(Local<FunctionTemplate> templ)
+            {
+                delete this->m_templateDecl;
+                this->m_templateDecl = new Eternal<FunctionTemplate>(this->m_isolationScope, templ);
+            }
+            
+            virtual void dispatch(const FunctionCallbackInfo<Value>& info)
+            {
+                this->invoke(info);
+            }
+            
+            /**
+             * Explicity invoke the vectorized function with the given V8 function callback info
+             */
+            inline void invoke(const FunctionCallbackInfo<Value>& info)
+            {
+                HandleScope handle_scope(info.GetIsolate());
+                
+                if (info.Length() != arity)
+                {
+                    this->throwException(info, "MissingFunctionException. The vectorized function arity does not match the number of provided arrays.");
+                    return;
+                }
+                
+                this->forwardInvoke(info, boost::mpl::int_<arity>());
+            }
+        protected:
+            mutable Eternal<FunctionTemplate> *m_templateDecl;
+            TFunction m_function;
+            
+            template <int TIndex>
+            struct arg_type
+            {
+                typedef typename boost::remove_const<
+                    typename boost::remove_reference<typename boost::mpl::at_c<TSignature, TIndex + 1>::type>::type
+                >::type type;
+                
+                BOOST_STATIC_ASSERT_MSG(detail::TypedArrayTraits<type>::isSupported, "The function argument type has no matching typed array.");
+            };
+            
+            /* Resolve the elements of the given typed array argument */
+            template <class TElement>
+            inline static bool resolveArray(Handle<Value> value, const TElement *&elements, size_t &length)
+            {
+                if (!detail::TypedArrayTraits<TElement>::is(value))
+                {
+                    return false;
+                }
+                
+                Local<ArrayBufferView> view = Local<ArrayBufferView>::Cast(static_cast<Local<Value> >(value));
+                elements = detail::typed_array_data<TElement>(view);
+                length = view->ByteLength() / sizeof(TElement);
+                
+                return true;
+            }
+            
+            inline void throwException(const FunctionCallbackInfo<Value>& info, const char *message)
+            {
+                info.GetIsolate()->ThrowException(String::NewFromUtf8(info.GetIsolate(), message));
+            }
+            
+            /* f.map(a) */
+            inline void forwardInvoke(const FunctionCallbackInfo<Value>& info, boost::mpl::int_<1>)
+            {
+                typedef typename arg_type<0>::type TArg0;
+                
+                const TArg0 *a = NULL;
+                size_t length = 0;
+                
+                if (!resolveArray(info[0], a, length))
+                {
+                    this->throwException(info, "TypeError. The provided argument is not a typed array of the function argument type.");
+                    return;
+                }
+                
+                Local<typename detail::TypedArrayTraits<TResult>::type> result = detail::new_typed_array<TResult>(info.GetIsolate(), length);
+                TResult *out = detail::typed_array_data<TResult>(result);
+                
+                for (size_t i = 0; i < length; ++i)
+                {
+                    out[i] = this->m_function(a[i]);
+                }
+                
+                info.GetReturnValue().Set(result);
+            }
+            
+            /* f.map(a, b) */
+            inline void forwardInvoke(const FunctionCallbackInfo<Value>& info, boost::mpl::int_<2>)
+            {
+                typedef typename arg_type<0>::type TArg0;
+                typedef typename arg_type<1>::type TArg1;
+                
+                const TArg0 *a = NULL;
+                const TArg1 *b = NULL;
+                size_t length = 0, otherLength = 0;
+                
+                if (!resolveArray(info[0], a, length) || !resolveArray(info[1], b, otherLength))
+                {
+                    this->throwException(info, "TypeError. The provided arguments are not typed arrays of the function arguments types.");
+                    return;
+                }
+                
+                if (length != otherLength)
+                {
+                    this->throwException(info, "RangeError. The provided typed arrays must have the same length.");
+                    return;
+                }
+                
+                Local<typename detail::TypedArrayTraits<TResult>::type> result = detail::new_typed_array<TResult>(info.GetIsolate(), length);
+                TResult *out = detail::typed_array_data<TResult>(result);
+                
+                for (size_t i = 0; i < length; ++i)
+                {
+                    out[i] = this->m_function(a[i], b[i]);
+                }
+                
+                info.GetReturnValue().Set(result);
+            }
+            
+            inline static void internalFunctionInvocationCallback(const FunctionCallbackInfo<Value>& info)
+            {
+                NativeVectorizedFunction *instance = static_cast<NativeVectorizedFunction *>(External::Cast(*info.Data())->Value());
+                instance->dispatch(info);
+            }
+        };
+    }
+}
+
+#endif
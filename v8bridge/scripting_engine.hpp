@@ -33,14 +33,34 @@
 
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
 #include <map>
 #include <vector>
+#include <thread>
+#include <boost/atomic.hpp>
+#include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/type_traits/is_class.hpp>
+#include <boost/utility/enable_if.hpp>
 
+#include <v8bridge/builtin/console.hpp>
+#include <v8bridge/builtin/performance.hpp>
+#include <v8bridge/builtin/timers.hpp>
 #include <v8bridge/conversion.hpp>
+#include <v8bridge/coroutine.hpp>
+#include <v8bridge/detail/mpsc_queue.hpp>
+#include <v8bridge/detail/tasks.hpp>
 #include <v8bridge/detail/typeid.hpp>
+#include <v8bridge/detail/script_cache.hpp>
+#include <v8bridge/detail/struct_shape.hpp>
+#include <v8bridge/engine_options.hpp>
+#include <v8bridge/heap_limits.hpp>
+#include <v8bridge/idle.hpp>
+#include <v8bridge/native/native_async_function.hpp>
 #include <v8bridge/native/native_class.hpp>
+#include <v8bridge/userland/userland_function.hpp>
 #include <v8bridge/version.hpp>
+#include <v8bridge/watchdog.hpp>
 
 namespace v8
 {
@@ -53,87 +73,190 @@ namespace v8
             std::string get_report_v8_exception(v8::Isolate* isolate, v8::TryCatch* try_catch);
         }
         
+/* The isolation scope data slot used to store the ScriptingEngine (see Isolate::SetData) */
+#ifndef V8BRIDGE_ISOLATE_DATA_SLOT
+#   define V8BRIDGE_ISOLATE_DATA_SLOT 0
+#endif
+        
         class V8_DECL ScriptingEngine
         {
         public:
             ScriptingEngine(bool registerBuiltinDeclaration = true)  :
+            m_activeIsolationScope(Isolate::GetCurrent()),
+            m_ownsIsolationScope(false),
+            m_threadHandoff(false),
+            m_stackSizeInBytes(0),
+            m_arrayBufferAllocator(NULL),
+            m_registeredContractsMap(new TNativeContractMap()),
+            m_registeredNativeClassesMap(new TNativeClassesContractMap()),
+            m_exposedTemplatesMap(new TExposedTemplatesMap()),
+            m_exposedObjectTemplatesMap(new TExposedObjectTemplatesMap()),
+            m_nativeClassesRegistry(new TNativeClassesRegistry()),
+            m_structShapesRegistry(new TStructShapesRegistry()),
+            m_pendingTasks(new TTasksQueue()),
+            m_pendingAsyncCalls(0),
+            m_timers(NULL),
+            m_console(NULL),
+            m_performance(NULL),
+            m_scriptCache(NULL),
+            m_captureStackOnTimeout(false),
+            m_heapBudget(0),
+            m_heapLimitScopeDepth(0),
+            m_underMemoryPressure(false),
+#if V8BRIDGE_HAS_IDLE_TASKS
+            m_idleTaskPlatform(NULL),
+#endif
+            m_idleLowMemoryHeapThreshold(0),
+            m_idleLowMemoryMinIdleTime(0)
+            {
+                this->initialize(registerBuiltinDeclaration);
+            }
+            
+#if V8BRIDGE_HAS_ENGINE_OPTIONS
+            /**
+             * Create an engine that owns a dedicated isolation scope, created with the given options.
+             * The isolation scope is entered by the engine and disposed when the engine is destroyed.
+             */
+            ScriptingEngine(const EngineOptions &options, bool registerBuiltinDeclaration = true)  :
+            m_activeIsolationScope(NULL),
+            m_ownsIsolationScope(true),
+            m_threadHandoff(options.threadHandoff),
+            m_stackSizeInBytes(options.stackSizeInBytes),
+            m_arrayBufferAllocator(NULL),
             m_registeredContractsMap(new TNativeContractMap()),
-            m_registeredNativeClassesMap(new TNativeClassesContractMap())
+            m_registeredNativeClassesMap(new TNativeClassesContractMap()),
+            m_exposedTemplatesMap(new TExposedTemplatesMap()),
+            m_exposedObjectTemplatesMap(new TExposedObjectTemplatesMap()),
+            m_nativeClassesRegistry(new TNativeClassesRegistry()),
+            m_structShapesRegistry(new TStructShapesRegistry()),
+            m_pendingTasks(new TTasksQueue()),
+            m_pendingAsyncCalls(0),
+            m_timers(NULL),
+            m_console(NULL),
+            m_performance(NULL),
+            m_scriptCache(NULL),
+            m_captureStackOnTimeout(false),
+            m_heapBudget(0),
+            m_heapLimitScopeDepth(0),
+            m_underMemoryPressure(false),
+#if V8BRIDGE_HAS_IDLE_TASKS
+            m_idleTaskPlatform(NULL),
+#endif
+            m_idleLowMemoryHeapThreshold(0),
+            m_idleLowMemoryMinIdleTime(0)
             {
                 //-------------------------------------------------
                 //  Create new isolation scope
                 //-------------------------------------------------
-                this->m_activeIsolationScope = Isolate::GetCurrent();
-                //this->m_activeIsolationScope->Enter();
-                
-                //-------------------------------------------------
-                // Create a temp scope
-                //-------------------------------------------------
-                HandleScope handle_scope(this->m_activeIsolationScope);
-                
-                //-------------------------------------------------
-                //  Create the active context
-                //-------------------------------------------------
-                
-                // Each processor gets its own context so different engines don't
-                // affect each other. Context::New returns a persistent handle which
-                // is what we need for the reference to remain after we return from
-                // this method. That persistent handle has to be disposed in the
-                // destructor.
-                Handle<Context> context = Context::New(this->m_activeIsolationScope, NULL);
-                context->Enter();
-                
-                this->m_context.Reset(this->m_activeIsolationScope, context);
-                
-                //-------------------------------------------------
-                // Enter the new context so all the following operations take place
-                // within it.
-                //-------------------------------------------------
-                Context::Scope context_scope(context);
-                
-                //-------------------------------------------------
-                //  Register the engine
-                //-------------------------------------------------
-                
-                s_isolationToEngineMap.insert(std::make_pair(this->m_activeIsolationScope, this));
-                
-                //-------------------------------------------------
-                //  Should we register some built-in functions?
-                //-------------------------------------------------
+                this->m_activeIsolationScope = detail::create_isolate(options, this->m_arrayBufferAllocator);
                 
-                if (registerBuiltinDeclaration)
+                if (this->m_threadHandoff)
                 {
-                    //this->exposeV8Function("sprintf", builtin::sprintf);
-                    //this->exposeV8Function("tosource", builtin::js_tosource);
+                    /* Initialize under a lock and detach, so the engine can be attached by any thread */
+                    Locker locker(this->m_activeIsolationScope);
+                    this->m_activeIsolationScope->Enter();
+                    this->applyStackLimit();
+                    this->initialize(registerBuiltinDeclaration);
+                    this->releaseThread();
+                }
+                else
+                {
+                    this->m_activeIsolationScope->Enter();
+                    this->applyStackLimit();
+                    this->initialize(registerBuiltinDeclaration);
                 }
             }
+#endif
             
             ~ScriptingEngine()
             {
-                //-------------------------------------------------
-                //  Remove ourselfs from the isolation to engine map
-                //-------------------------------------------------
-                
-                s_isolationToEngineMap.erase(s_isolationToEngineMap.find(this->m_activeIsolationScope));
+#if V8BRIDGE_HAS_ENGINE_OPTIONS
+                if (this->m_threadHandoff)
+                {
+                    /* A detached engine should be re-attached to the destroying thread before we can release it */
+                    Locker locker(this->m_activeIsolationScope);
+                    this->acquireThread();
+                    this->dispose();
+                }
+                else
+#endif
+                {
+                    this->dispose();
+                }
                 
-                //-------------------------------------------------
-                //  Dispose
-                //-------------------------------------------------
+                if (this->m_ownsIsolationScope)
+                {
+                    this->m_activeIsolationScope->Dispose();
+                    delete this->m_arrayBufferAllocator;
+                }
+            }
+            
+            //==========================================================================
+            //  Threads handoff
+            //==========================================================================
+            
+            /**
+             * Enter the engine isolation scope and context on the calling thread.
+             * Engines created with EngineOptions::threadHandoff are detached after their creation and should be attached
+             * (while holding a v8::Locker) by the thread that uses them. See ThreadScope.
+             * The engine stack limit (EngineOptions::stackSizeInBytes) is computed from the calling thread stack.
+             */
+            inline void acquireThread()
+            {
+                this->m_activeIsolationScope->Enter();
+                this->applyStackLimit();
                 
-                // Dispose the persistent handles.  When noone else has any
-                // references to the objects stored in the handles they will be
-                // automatically reclaimed
-                this->m_context.Reset();
+                HandleScope handle_scope(this->m_activeIsolationScope);
+                Local<Context>::New(this->m_activeIsolationScope, this->m_context)->Enter();
+            }
+            
+            /**
+             * Leave the engine context and isolation scope on the calling thread (the opposite of acquireThread).
+             */
+            inline void releaseThread()
+            {
+                {
+                    HandleScope handle_scope(this->m_activeIsolationScope);
+                    Local<Context>::New(this->m_activeIsolationScope, this->m_context)->Exit();
+                }
                 
-                //this->m_activeIsolationScope->Exit();
-                //this->m_activeIsolationScope->Dispose();
+                this->m_activeIsolationScope->Exit();
             }
             
+            /**
+             * Locks the engine isolation scope and attaches the engine to the current thread for the scope lifetime.
+             *
+             * For example:
+             *      {
+             *          ScriptingEngine::ThreadScope scope(engine);
+             *          engine->execute("...");
+             *      }
+             */
+            class ThreadScope
+            {
+            public:
+                ThreadScope(ScriptingEngine *engine) : m_locker(engine->getActiveIsolationScope()), m_engine(engine)
+                {
+                    this->m_engine->acquireThread();
+                }
+                
+                ~ThreadScope()
+                {
+                    this->m_engine->releaseThread();
+                }
+            private:
+                ThreadScope(const ThreadScope &);
+                ThreadScope &operator=(const ThreadScope &);
+                
+                Locker m_locker;
+                ScriptingEngine *m_engine;
+            };
+            
             //==========================================================================
             //  Getters & Setters
             //==========================================================================
             inline Isolate *getActiveIsolationScope() { return this->m_activeIsolationScope; }
-            //Persistent<Context> getCurrentContext() { return this->*m_context; };
+            inline bool ownsIsolationScope() const { return this->m_ownsIsolationScope; }
             
             //==========================================================================
             //  Expose
@@ -158,6 +281,17 @@ namespace v8
                 return this;
             }
             
+            /**
+             * Set a given handle on the global scope of the given context (see createContext).
+             */
+            inline ScriptingEngine *setAtGlobalScope(Handle<Context> context, std::string key, Handle<Value> value)
+            {
+                HandleScope handle_scope(this->m_activeIsolationScope);
+                Context::Scope context_scope(context);
+                
+                return this->setAtGlobalScope(key, value);
+            }
+            
             /**
              * Convert the given value to V8 JS handle and set it in the global scope.
              *
@@ -199,6 +333,17 @@ namespace v8
             }
             
             
+            /**
+             * Get handle declared on the global scope of the given context (see createContext).
+             */
+            inline Handle<Value> getFromGlobalScope(Handle<Context> context, std::string key)
+            {
+                EscapableHandleScope handle_scope(this->m_activeIsolationScope);
+                Context::Scope context_scope(context);
+                
+                return handle_scope.Escape(this->getFromGlobalScope(key));
+            }
+            
             /**
              * Get value, converted by the conversion API, declared on the global scope, associated with the specified key (variable name).
              *
@@ -308,10 +453,86 @@ namespace v8
                 //  Register for internal use
                 //-------------------------------------------------
                 this->m_registeredContractsMap->insert(std::make_pair(name, adapter));
+                this->trackExposedTemplate(name, funcDecl->getTemplate());
+                
+                return this;
+            }
+            
+#if V8BRIDGE_HAS_PROMISES
+            /**
+             * Expose the given native function (function pointer or callable) as an async JS function.
+             * The function is run on the engine async worker pool (see setAsyncWorkerPool) and the JS call immediately returns
+             * a Promise, which is resolved (or rejected) by runPending once the function completes.
+             * For more information, see native_async_function.hpp.
+             *
+             * Example:
+             *      engine->exposeAsync(&read_file, "readFile");
+             *      JS: readFile("/tmp/foo").then(function (contents) { ... });
+             */
+            template <typename TFunction>
+            inline typename boost::disable_if<boost::is_class<TFunction>, ScriptingEngine *>::type
+            exposeAsync(TFunction functionPointer, std::string name)
+            {
+                return this->exposeAsync(functionPointer, get_signature(functionPointer), name);
+            }
+            
+            template <typename TCallable>
+            inline typename boost::enable_if<boost::is_class<TCallable>, ScriptingEngine *>::type
+            exposeAsync(TCallable callable, std::string name)
+            {
+                return this->exposeAsync(callable, get_callable_signature(callable), name);
+            }
+            
+            template <class TFunction, class TSignature>
+            inline ScriptingEngine *exposeAsync(TFunction function, TSignature signature, std::string name)
+            {
+                HandleScope handle_scope(this->m_activeIsolationScope);
+                
+#if V8BRIDGE_DEBUG
+                assert(this->m_registeredContractsMap->find(name) == this->m_registeredContractsMap->end());
+#else
+                if (this->m_registeredContractsMap->find(name) != this->m_registeredContractsMap->end())
+                {
+                    return this;
+                }
+#endif
+                
+                typedef NativeAsyncFunction<ScriptingEngine, TFunction, TSignature> TAsyncFunction;
+                boost::shared_ptr<TAsyncFunction> adapter(new TAsyncFunction(this, function, this->getAsyncWorkerPool()));
+                
+                this->setAtGlobalScope(name, adapter->getTemplate()->GetFunction());
+                
+                this->m_registeredContractsMap->insert(std::make_pair(name, adapter));
+                this->trackExposedTemplate(name, adapter->getTemplate());
                 
                 return this;
             }
             
+            /**
+             * Set the worker pool used by the async functions exposed from now on. A pool may be shared by several engines.
+             * If no pool was set, the engine creates a pool with a worker per hardware thread on the first exposeAsync.
+             */
+            inline ScriptingEngine *setAsyncWorkerPool(const boost::shared_ptr<AsyncWorkerPool> &workerPool)
+            {
+                this->m_asyncWorkerPool = workerPool;
+                return this;
+            }
+            
+            inline boost::shared_ptr<AsyncWorkerPool> getAsyncWorkerPool()
+            {
+                if (!this->m_asyncWorkerPool)
+                {
+                    this->m_asyncWorkerPool.reset(new AsyncWorkerPool());
+                }
+                
+                return this->m_asyncWorkerPool;
+            }
+            
+            /* Used by NativeAsyncFunction to track the calls that are still running on the worker pool */
+            inline void beginAsyncCall() { this->m_pendingAsyncCalls.fetch_add(1, boost::memory_order_relaxed); }
+            inline void endAsyncCall() { this->m_pendingAsyncCalls.fetch_sub(1, boost::memory_order_release); }
+#endif
+            
             /**
              * Expose the given class endpoint to JS.
              * For more information on NativeClass, see native_class.hpp.
@@ -366,8 +587,16 @@ namespace v8
                 //-------------------------------------------------
                 //  Register for internal use
                 //-------------------------------------------------
-                this->m_registeredContractsMap->insert(std::make_pair(TypeId<TClass>().name(), adapter));
-                this->m_registeredNativeClassesMap->insert(std::make_pair(TypeId<TClass>().name(), adapter.get()));
+                this->m_registeredContractsMap->insert(std::make_pair(name, adapter));
+                this->m_registeredNativeClassesMap->insert(std::make_pair(name, adapter.get()));
+                this->trackExposedTemplate(name, classDecl->getTemplate());
+                
+                size_t index = TypeIndex<TResolvedType>::value();
+                if (index >= this->m_nativeClassesRegistry->size())
+                {
+                    this->m_nativeClassesRegistry->resize(index + 1, NULL);
+                }
+                (*this->m_nativeClassesRegistry)[index] = adapter.get();
                 
                 return this;
             }
@@ -397,9 +626,14 @@ namespace v8
                 //-------------------------------------------------
                 //  Remove from the lists
                 //-------------------------------------------------
+                NativeEndpoint *endpoint = this->m_registeredNativeClassesMap->find(name)->second;
+                std::replace(this->m_nativeClassesRegistry->begin(), this->m_nativeClassesRegistry->end(), endpoint, (NativeEndpoint *)NULL);
+                
                 this->m_registeredNativeClassesMap->erase(name);
                 this->m_registeredContractsMap->erase(name); // -1 to shared pointer
                 
+                this->untrackExposedTemplate(name);
+                
                 return this;
             }
             
@@ -407,18 +641,50 @@ namespace v8
             // Class contracts (used to convert between types)
             //==========================================================================
             
+            /**
+             * Get the exposed class endpoint of the given type (or NULL if the type was not exposed).
+             * This is a flat table lookup (see TypeIndex), so it's cheap enough to be done on every wrapped pointer return.
+             */
             template<typename TClass>
             inline NativeEndpoint *getClassContractByType()
             {
-                TNativeClassesContractMap::const_iterator it = this->m_registeredNativeClassesMap->find(TypeId<TClass>().name());
-                if (it != this->m_registeredNativeClassesMap->end())
+                size_t index = TypeIndex<TClass>::value();
+                if (index < this->m_nativeClassesRegistry->size())
                 {
-                    return it->second;
+                    return (*this->m_nativeClassesRegistry)[index];
                 }
                 
                 return 0;
             }
             
+            /**
+             * Get the JS shape (internalized keys and object template) of the given V8BRIDGE_STRUCT declared struct.
+             * The shape is created on the first request and cached for the engine lifetime.
+             */
+            template<typename TStruct>
+            inline detail::StructShape *getStructShape()
+            {
+                typedef detail::StructDescriptor<TStruct> TDescriptor;
+                
+                size_t index = TypeIndex<TStruct>::value();
+                if (index < this->m_structShapesRegistry->size() && (*this->m_structShapesRegistry)[index])
+                {
+                    return (*this->m_structShapesRegistry)[index].get();
+                }
+                
+                if (index >= this->m_structShapesRegistry->size())
+                {
+                    this->m_structShapesRegistry->resize(index + 1);
+                }
+                
+                boost::shared_ptr<detail::StructShape> shape(new detail::StructShape(this->m_activeIsolationScope,
+                                                                                     TDescriptor::fieldNames(),
+                                                                                     TDescriptor::fieldsCount));
+                (*this->m_structShapesRegistry)[index] = shape;
+                
+                return shape.get();
+            }
+            
             
             //==========================================================================
             //  Execution
@@ -430,6 +696,82 @@ namespace v8
                 this->v8Eval(scriptCode, fileName);
             }
             
+            /**
+             * Execute the given script in the given context (see createContext).
+             */
+            inline void execute(Handle<Context> context, const std::string &scriptCode, const std::string &fileName = "")
+            {
+                HandleScope handle_scope(this->m_activeIsolationScope);
+                Context::Scope context_scope(context);
+                
+                this->v8Eval(scriptCode, fileName);
+            }
+            
+            /**
+             * Evaluate the given script in the given context (see createContext).
+             */
+            template <typename TResult>
+            inline TResult eval(Handle<Context> context, const std::string &scriptCode, const std::string &fileName = "")
+            {
+                HandleScope handle_scope(this->m_activeIsolationScope);
+                Context::Scope context_scope(context);
+                
+                return this->eval<TResult>(scriptCode, fileName);
+            }
+            
+            /**
+             * Execute the given script, terminating it if it's still running when the given deadline is reached.
+             * A terminated execution raises a ScriptTimeoutError (see setCaptureStackOnTimeout).
+             *
+             * The deadlines of all the engines are enforced by a single shared watchdog thread.
+             */
+            inline void execute(const std::string &scriptCode, std::chrono::steady_clock::time_point deadline, const std::string &fileName = "")
+            {
+                HandleScope handle_scope(this->m_activeIsolationScope);
+                
+                detail::WatchdogScope watchdog(this->m_activeIsolationScope, deadline, this->m_captureStackOnTimeout);
+                this->v8Eval(scriptCode, fileName);
+                watchdog.finish();
+            }
+            
+            /**
+             * Evaluate the given script, terminating it if it's still running when the given deadline is reached.
+             * A terminated evaluation raises a ScriptTimeoutError (see setCaptureStackOnTimeout).
+             *
+             * Example:
+             *      int n = engine->eval<int>(code, std::chrono::steady_clock::now() + std::chrono::milliseconds(50));
+             */
+            template <typename TResult>
+            inline TResult eval(const std::string &scriptCode, std::chrono::steady_clock::time_point deadline, const std::string &fileName = "")
+            {
+                HandleScope handle_scope(this->m_activeIsolationScope);
+                
+                detail::WatchdogScope watchdog(this->m_activeIsolationScope, deadline, this->m_captureStackOnTimeout);
+                Handle<Value> handle = this->v8Eval(scriptCode, fileName);
+                watchdog.finish();
+                
+                TResult result;
+                if (!JsToNative<TResult>(this->m_activeIsolationScope, result, handle))
+                {
+                    String::Utf8Value stringifyResult(handle);
+                    std::stringstream io;
+                    io << "The evaluated result does not match the specified TResult (" << TypeId<TResult>().name() << ")."
+                    << std::endl << "Stingify evaluated result: " << *stringifyResult;
+                    throw std::runtime_error(io.str());
+                }
+                return result;
+            }
+            
+            /**
+             * Capture the JS stack of scripts that are terminated since they've exceeded their deadline
+             * (see ScriptTimeoutError::getStackTrace). Disabled by default.
+             */
+            inline ScriptingEngine *setCaptureStackOnTimeout(bool captureStack)
+            {
+                this->m_captureStackOnTimeout = captureStack;
+                return this;
+            }
+            
             template <typename TResult>
             inline TResult eval(const std::string &scriptCode, const std::string &fileName = "")
             {
@@ -457,22 +799,15 @@ namespace v8
                 Handle<Context> context = this->m_activeIsolationScope->GetCurrentContext();
                 Context::Scope context_scope(context);
                 
-                TryCatch try_catch;
+                HeapLimitScope heap_limit_scope(this);
+                
+                V8BRIDGE_TRY_CATCH(try_catch, this->m_activeIsolationScope);
                 //try_catch.SetVerbose(true);
                 //try_catch.SetCaptureMessage(true);
                 
-                Handle<Script> compiledScript;
-                if (fileName.empty())
-                {
-                    compiledScript = Script::Compile(String::NewFromUtf8(this->m_activeIsolationScope, scriptCode.c_str()));
-                }
-                else
-                {
-                    compiledScript = Script::Compile(
-                                                     String::NewFromUtf8(this->m_activeIsolationScope, scriptCode.c_str()),
-                                                     String::NewFromUtf8(this->m_activeIsolationScope, fileName.c_str())
-                                                     );
-                }
+                /* Repeated evaluations of the same source are served from the compiled scripts cache,
+                    so they're only bound to the context and executed */
+                Local<UnboundScript> compiledScript = this->m_scriptCache->compile(scriptCode, fileName);
                 
                 if (compiledScript.IsEmpty()) {
                     String::Utf8Value error(try_catch.Exception());
@@ -482,7 +817,10 @@ namespace v8
                     return v8::Undefined(this->m_activeIsolationScope);
                 }
                 
-                Local<Value> result = compiledScript->Run();
+                Local<Value> result = compiledScript->BindToCurrentContext()->Run();
+                
+                /* Raises a HeapBudgetExceededError */
+                this->checkHeapLimits();
                 
                 if (result.IsEmpty())
                 {
@@ -499,42 +837,498 @@ namespace v8
             }
             
             //==========================================================================
-            //  Misc
-            //==========================================================================
-            inline std::string getStackTrace(int limit = 10)
-            {
-                HandleScope handle_scope(this->m_activeIsolationScope);
-                
-                Handle<StackTrace> stackTrace = StackTrace::CurrentStackTrace(this->m_activeIsolationScope, limit, StackTrace::kOverview);
-                
-                std::ostringstream io;
-                for (int i = 0; i < stackTrace->GetFrameCount(); ++i)
-                {
-                    Handle<StackFrame> frame = stackTrace->GetFrame(i);
-                    
-                    io << *String::Utf8Value(frame->GetFunctionName())
-                    << " [line: " << frame->GetLineNumber() << ", column: " << frame->GetColumn() << "]"
-                    << std::endl;
-                }
-                return io.str();
-            }
-            
-            //==========================================================================
-            //  Static helpers
+            //  Compiled scripts cache
             //==========================================================================
             
             /**
-             * Get the scripting engine instance associated with the given isolation scope
+             * Set the compiled scripts cache budget, in bytes of cached source code (0 disables the cache).
+             * The least recently used scripts are evicted once the budget is exceeded.
              */
-            inline static ScriptingEngine *EngineFromIsolationScope(Isolate *isolate)
+            inline ScriptingEngine *setScriptCacheBudget(size_t budget)
+            {
+                this->m_scriptCache->setBudget(budget);
+                return this;
+            }
+            
+            inline ScriptingEngine *clearScriptCache()
+            {
+                this->m_scriptCache->clear();
+                return this;
+            }
+            
+            inline ScriptCacheStats getScriptCacheStats() const
+            {
+                return this->m_scriptCache->getStats();
+            }
+            
+            /**
+             * Persist the compiled scripts code (V8 code cache) in the given directory, so new processes
+             * can skip compiling scripts that were already compiled. An empty directory disables the persistent cache.
+             * Requires V8 6.0 or later (otherwise the scripts are always compiled from source).
+             */
+            inline ScriptingEngine *setCodeCacheDirectory(const std::string &directory)
+            {
+                this->m_scriptCache->setCodeCacheDirectory(directory);
+                return this;
+            }
+            
+            inline CodeCacheStats getCodeCacheStats() const
+            {
+                detail::CodeCache *codeCache = this->m_scriptCache->getCodeCache();
+                if (codeCache == NULL)
+                {
+                    CodeCacheStats stats = { 0, 0, 0, 0 };
+                    return stats;
+                }
+                
+                return codeCache->getStats();
+            }
+            
+            //==========================================================================
+            //  Tasks
+            //==========================================================================
+            
+            typedef boost::function<void (ScriptingEngine &)> TTask;
+            
+            /**
+             * Post a task to be run on the engine thread (by runPending).
+             * This is the only engine method that may be called by any thread. Posting never blocks.
+             *
+             * Example:
+             *      // On an I/O thread:
+             *      engine->post(boost::bind(&on_read_completed, _1, buffer));
+             */
+            inline void post(const TTask &task)
+            {
+                this->m_pendingTasks->push(task);
+            }
+            
+            /**
+             * Post a callable, which receives the engine (ScriptingEngine &) and returns TResult, to be run on the engine thread.
+             * The returned future receives the callable result (or the exception it raised).
+             *
+             * Example:
+             *      std::future<int> n = engine->post<int>(boost::bind(&UserlandFunction::invoke<int, int>, add, 1));
+             */
+            template <class TResult, class TCallable>
+            inline std::future<TResult> post(const TCallable &callable)
+            {
+                detail::PromisedTask<TResult, TCallable, ScriptingEngine> task(callable);
+                std::future<TResult> future = task.promise->get_future();
+                
+                this->post(TTask(task));
+                return future;
+            }
+            
+            /**
+             * Post a script evaluation to be run on the engine thread.
+             * The returned future receives the evaluated result (or the raised exception).
+             */
+            template <class TResult>
+            inline std::future<TResult> postEval(const std::string &scriptCode, const std::string &fileName = "")
+            {
+                return this->post<TResult>(detail::EvalTask<TResult, ScriptingEngine>(scriptCode, fileName));
+            }
+            
+            /**
+             * Run the posted tasks, up to the given number of tasks (0 runs all the pending tasks).
+             * The V8 microtasks queue is drained after every V8BRIDGE_MICROTASKS_BATCH_SIZE tasks, and before returning.
+             * Should be called on the engine thread. Returns the number of tasks that were run.
+             *
+             * An exception raised by a task (posted without a future) is propagated, the remaining tasks are left pending.
+             */
+            inline size_t runPending(size_t budget = 0)
+            {
+                size_t count = 0;
+                TTask task;
+                
+                HeapLimitScope heap_limit_scope(this);
+                
+                while ((budget == 0 || count < budget) && this->m_pendingTasks->pop(task))
+                {
+                    {
+                        HandleScope handle_scope(this->m_activeIsolationScope);
+                        task(*this);
+                    }
+                    
+                    if (++count % V8BRIDGE_MICROTASKS_BATCH_SIZE == 0)
+                    {
+                        detail::run_microtasks(this->m_activeIsolationScope);
+                    }
+                }
+                
+                detail::run_microtasks(this->m_activeIsolationScope);
+                
+                return count;
+            }
+            
+#if V8BRIDGE_HAS_COROUTINES
+            /**
+             * Invoke the given JS function and return an awaitable over its result (C++20 coroutines, see coroutine.hpp).
+             * When the function returns a promise (e.g. an async function), the awaiting coroutine is resumed by runPending
+             * once the promise settles. The value is converted to TResult, while rejections (and exceptions) are raised as std::runtime_error.
+             *
+             * Example:
+             *      int n = co_await engine.invokeAsync<int>(fetchCount, "users");
+             */
+            template <class TResult, class ...TArgs>
+            inline detail::PromiseAwaiter<TResult, ScriptingEngine> invokeAsync(Handle<Function> function, TArgs... args)
+            {
+                HandleScope handle_scope(this->m_activeIsolationScope);
+                Local<Context> context = this->m_activeIsolationScope->GetCurrentContext();
+                
+                Local<Value> argv[] = { NativeToJs<TArgs>(this->m_activeIsolationScope, args)..., Local<Value>() };
+                
+                HeapLimitScope heap_limit_scope(this);
+                
+                TryCatch try_catch(this->m_activeIsolationScope);
+                Local<Value> result;
+                if (!function->Call(context, context->Global(), sizeof...(TArgs), argv).ToLocal(&result))
+                {
+                    String::Utf8Value error(this->m_activeIsolationScope, try_catch.Exception());
+                    return detail::PromiseAwaiter<TResult, ScriptingEngine>(this, this->m_activeIsolationScope,
+                                                                            std::string(*error ? *error : "<string conversion failed>"));
+                }
+                
+                return detail::PromiseAwaiter<TResult, ScriptingEngine>(this, this->m_activeIsolationScope, result);
+            }
+            
+            template <class TResult, class ...TArgs>
+            inline detail::PromiseAwaiter<TResult, ScriptingEngine> invokeAsync(UserlandFunction &function, TArgs... args)
+            {
+                HandleScope handle_scope(this->m_activeIsolationScope);
+                return this->invokeAsync<TResult>(Handle<Function>(function.getFunction()), args...);
+            }
+#endif
+            
+            /**
+             * Does the engine got pending tasks? May be called by any thread.
+             */
+            inline bool hasPendingTasks() const
+            {
+                return !this->m_pendingTasks->empty();
+            }
+            
+            //==========================================================================
+            //  Timers
+            //==========================================================================
+            
+            /**
+             * Call the JS timers (setTimeout and setInterval callbacks) that expired until the given time,
+             * then drain the V8 microtasks queue. Should be called on the engine thread, from the embedder loop.
+             * Returns the number of called timers.
+             *
+             * Exceptions raised by the timers callbacks are swallowed (as there's no caller to report them to).
+             *
+             * Example:
+             *      while (engine->hasPendingTimers())
+             *      {
+             *          engine->runTimers();
+             *          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+             *      }
+             */
+            inline size_t runTimers(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now())
+            {
+                HandleScope handle_scope(this->m_activeIsolationScope);
+                
+                HeapLimitScope heap_limit_scope(this);
+                
+                size_t count = this->m_timers->run(now);
+                detail::run_microtasks(this->m_activeIsolationScope);
+                
+                return count;
+            }
+            
+            /**
+             * Does the engine got pending timers?
+             */
+            inline bool hasPendingTimers() const
+            {
+                return this->m_timers->size() > 0;
+            }
+            
+            //==========================================================================
+            //  Console
+            //==========================================================================
+            
+            /**
+             * Set the sink of the built-in console messages (by default, messages are written to the standard output and error).
+             * The sink is called by the console writer thread, not by the engine thread.
+             *
+             * Example:
+             *      engine->setConsoleSink([](builtin::Console::Level level, const std::string &message) { logger.write(level, message); });
+             */
+            inline ScriptingEngine *setConsoleSink(const builtin::Console::TSink &sink)
             {
-                std::map<Isolate *, ScriptingEngine *>::const_iterator it = s_isolationToEngineMap.find(isolate);
-                if (it == s_isolationToEngineMap.end())
+                if (this->m_console != NULL)
                 {
-                    return 0;
+                    this->m_console->setSink(sink);
                 }
                 
-                return it->second;
+                return this;
+            }
+            
+            /**
+             * Get the built-in console (e.g. to flush it or to read its dropped messages count).
+             * Returns NULL if the engine was created without the built-in declarations.
+             */
+            inline builtin::Console *getConsole() const { return this->m_console; }
+            
+            /**
+             * Get the built-in performance object, which holds the scripts performance marks and measures histograms.
+             * Returns NULL if the engine was created without the built-in declarations.
+             */
+            inline builtin::Performance *getPerformance() const { return this->m_performance; }
+            
+            //==========================================================================
+            //  Heap limits & memory pressure
+            //==========================================================================
+            
+            /**
+             * Set the engine heap budget, in bytes (0, the default, disables the budget).
+             *
+             * The used heap size is checked after each evaluation. When it exceeds the budget, a full garbage collection
+             * is performed and if the used heap still exceeds the budget, a HeapBudgetExceededError is raised,
+             * so the caller can shed the script work (e.g. reset or recycle the engine).
+             * Evaluations nested in a JS call (e.g. made by a native function) are not checked, since the error can't be raised through JS frames.
+             */
+            inline ScriptingEngine *setHeapBudget(size_t budget)
+            {
+                this->m_heapBudget = budget;
+                return this;
+            }
+            
+            inline size_t getHeapBudget() const { return this->m_heapBudget; }
+            
+#if V8BRIDGE_HAS_MEMORY_PRESSURE
+            /**
+             * Forward the process memory pressure level to V8 (see Isolate::MemoryPressureNotification).
+             * While the pressure level is not kNone, isUnderMemoryPressure() returns true, so new script work can be shed.
+             */
+            inline ScriptingEngine *notifyMemoryPressure(MemoryPressureLevel level)
+            {
+                this->m_underMemoryPressure = level != MemoryPressureLevel::kNone;
+                this->m_activeIsolationScope->MemoryPressureNotification(level);
+                
+                return this;
+            }
+#endif
+            
+            /**
+             * Ask V8 to release as much memory as possible (performs a full garbage collection).
+             */
+            inline ScriptingEngine *notifyLowMemory()
+            {
+                detail::low_memory_notification(this->m_activeIsolationScope);
+                return this;
+            }
+            
+            inline bool isUnderMemoryPressure() const { return this->m_underMemoryPressure; }
+            
+            //==========================================================================
+            //  Idle time
+            //==========================================================================
+            
+#if V8BRIDGE_HAS_IDLE_TASKS
+            /**
+             * Set the platform whose idle tasks are run by onIdle (the platform should be created with idle tasks support,
+             * e.g. platform::NewDefaultPlatform(0, platform::IdleTaskSupport::kEnabled)). Not owned by the engine.
+             * Required for onIdle to perform any idle time work.
+             */
+            inline ScriptingEngine *setIdleTaskPlatform(Platform *platform)
+            {
+                this->m_idleTaskPlatform = platform;
+                return this;
+            }
+#endif
+            
+            /**
+             * Perform a full garbage collection (see notifyLowMemory) on idle time, when the used heap exceeds the given threshold
+             * and the available idle time is at least the given minimal idle time. A zero threshold disables the policy.
+             */
+            inline ScriptingEngine *setIdleLowMemoryPolicy(size_t usedHeapThreshold, std::chrono::milliseconds minIdleTime = std::chrono::milliseconds(50))
+            {
+                this->m_idleLowMemoryHeapThreshold = usedHeapThreshold;
+                this->m_idleLowMemoryMinIdleTime = minIdleTime;
+                return this;
+            }
+            
+            /**
+             * Notify the engine that the embedder is idle until the given deadline, so V8 can perform its garbage
+             * collection work (and idle tasks) now, instead of in the middle of the next request.
+             * Returns true if V8 has no more idle time work to do (so the embedder may stop calling onIdle until the next request).
+             *
+             * Note that on V8 5.4 or later, the idle time work requires the platform to be set (see setIdleTaskPlatform), since
+             * the deadline is expressed in the platform clock. Without it, onIdle only applies the low memory policy
+             * (see setIdleLowMemoryPolicy) and returns false.
+             *
+             * Example:
+             *      // Between requests
+             *      engine->onIdle(std::chrono::steady_clock::now() + std::chrono::milliseconds(5));
+             */
+            inline bool onIdle(std::chrono::steady_clock::time_point deadline)
+            {
+                std::chrono::steady_clock::duration idleTime = deadline - std::chrono::steady_clock::now();
+                if (idleTime <= std::chrono::steady_clock::duration::zero())
+                {
+                    return false;
+                }
+                
+                //-------------------------------------------------
+                //  Low memory policy
+                //-------------------------------------------------
+                
+                if (this->m_idleLowMemoryHeapThreshold > 0
+                    && idleTime >= this->m_idleLowMemoryMinIdleTime
+                    && detail::get_used_heap_size(this->m_activeIsolationScope) > this->m_idleLowMemoryHeapThreshold)
+                {
+                    detail::low_memory_notification(this->m_activeIsolationScope);
+                    
+                    idleTime = deadline - std::chrono::steady_clock::now();
+                    if (idleTime <= std::chrono::steady_clock::duration::zero())
+                    {
+                        return false;
+                    }
+                }
+                
+                //-------------------------------------------------
+                //  Idle tasks & incremental GC
+                //-------------------------------------------------
+                
+                double idleTimeInSeconds = std::chrono::duration<double>(idleTime).count();
+                
+#if V8BRIDGE_HAS_IDLE_TASKS
+                return detail::run_idle_tasks(this->m_activeIsolationScope, this->m_idleTaskPlatform, idleTimeInSeconds);
+#else
+                return detail::run_idle_tasks(this->m_activeIsolationScope, idleTimeInSeconds);
+#endif
+            }
+            
+            //==========================================================================
+            //  Contexts
+            //==========================================================================
+            
+            /**
+             * Create a new context, isolated from the engine context and from any other created context,
+             * with the exposed functions and classes installed on its global scope.
+             *
+             * The context is built from the templates shared by all the contexts of the engine, so creating
+             * it is much cheaper than creating a new engine (and isolation scope). Compiled scripts are shared as well.
+             *
+             * The returned handle belongs to the caller handle scope. To keep the context, store it in a Persistent handle.
+             * Then, pass it to execute, eval, setAtGlobalScope or getFromGlobalScope in order to use it.
+             *
+             * Example:
+             *      Persistent<Context> tenant(isolate, engine->createContext());
+             *      ...
+             *      HandleScope handle_scope(isolate);
+             *      int n = engine->eval<int>(Local<Context>::New(isolate, tenant), "add(1, 2)");
+             *
+             * Note that functions and classes exposed after the context creation are not installed in it.
+             * Once the context is no longer used, it should be released with releaseContext.
+             */
+            inline Local<Context> createContext()
+            {
+                EscapableHandleScope handle_scope(this->m_activeIsolationScope);
+                
+                HeapLimitScope heap_limit_scope(this);
+                
+                Local<Context> context = Context::New(this->m_activeIsolationScope, NULL);
+                this->installExposedTemplates(context);
+                
+                return handle_scope.Escape(context);
+            }
+            
+            /**
+             * Release the native resources that belong to the given context (see createContext):
+             * its pending timers are cancelled and the native class instances that were bound to its JS objects are freed.
+             *
+             * The context JS objects should no longer be used after this call (i.e. the context Persistent handle should be reset).
+             */
+            inline void releaseContext(Handle<Context> context)
+            {
+                HandleScope handle_scope(this->m_activeIsolationScope);
+                
+                this->m_timers->clear(context);
+                
+                for (TNativeClassesContractMap::iterator it = this->m_registeredNativeClassesMap->begin(); it != this->m_registeredNativeClassesMap->end(); ++it)
+                {
+                    it->second->releaseInstances(context);
+                }
+                
+                this->m_activeIsolationScope->ContextDisposedNotification();
+            }
+            
+            /**
+             * Get the engine own context (the one that's used by default).
+             */
+            inline Local<Context> getContext()
+            {
+                EscapableHandleScope handle_scope(this->m_activeIsolationScope);
+                return handle_scope.Escape(Local<Context>::New(this->m_activeIsolationScope, this->m_context));
+            }
+            
+            //==========================================================================
+            //  Reset
+            //==========================================================================
+            
+            /**
+             * Discard the engine context and replace it with a fresh one, without tearing down the isolation scope.
+             *
+             * The exposed functions and classes are re-installed on the new global scope from their already built templates,
+             * and the native instances that were bound to JS objects of the discarded context are released.
+             * Contexts created by createContext are not affected.
+             * Compiled scripts (see setScriptCacheBudget) and struct shapes are context independent and are kept.
+             *
+             * Note that any other value set on the global scope (e.g. using setAtGlobalScope) is discarded, and
+             * that native pointers or handles obtained from the discarded context should not be used afterwards.
+             */
+            inline ScriptingEngine *reset()
+            {
+                HandleScope handle_scope(this->m_activeIsolationScope);
+                
+                //-------------------------------------------------
+                //  Discard the current context
+                //-------------------------------------------------
+                
+                Local<Context> discarded = Local<Context>::New(this->m_activeIsolationScope, this->m_context);
+                discarded->Exit();
+                
+                /* Cancel the timers and release the native instances of the discarded context */
+                this->releaseContext(discarded);
+                this->m_context.Reset();
+                
+                //-------------------------------------------------
+                //  Create and enter the new context
+                //-------------------------------------------------
+                
+                Handle<Context> context = Context::New(this->m_activeIsolationScope, NULL);
+                context->Enter();
+                
+                this->m_context.Reset(this->m_activeIsolationScope, context);
+                this->installExposedTemplates(context);
+                
+                return this;
+            }
+            
+            //==========================================================================
+            //  Misc
+            //==========================================================================
+            inline std::string getStackTrace(int limit = 10)
+            {
+                return detail::format_current_stack_trace(this->m_activeIsolationScope, limit);
+            }
+            
+            //==========================================================================
+            //  Static helpers
+            //==========================================================================
+            
+            /**
+             * Get the scripting engine instance associated with the given isolation scope
+             */
+            inline static ScriptingEngine *EngineFromIsolationScope(Isolate *isolate)
+            {
+                return static_cast<ScriptingEngine *>(isolate->GetData(V8BRIDGE_ISOLATE_DATA_SLOT));
             }
             
             /**
@@ -546,23 +1340,343 @@ namespace v8
             }
             
         private:
+            /**
+             * Marks an engine call that runs JS (eval, runPending etc.). The heap budget is checked only by the outermost call,
+             * so a nested call (e.g. by a native function) won't raise the error through the JS frames of its caller.
+             */
+            class HeapLimitScope
+            {
+            public:
+                HeapLimitScope(ScriptingEngine *engine) : m_engine(engine)
+                {
+                    ++this->m_engine->m_heapLimitScopeDepth;
+                }
+                
+                ~HeapLimitScope()
+                {
+                    --this->m_engine->m_heapLimitScopeDepth;
+                }
+            private:
+                HeapLimitScope(const HeapLimitScope &);
+                HeapLimitScope &operator=(const HeapLimitScope &);
+                
+                ScriptingEngine *m_engine;
+            };
+            
+            /**
+             * Is the current engine call the outermost one, i.e. there are no JS frames below it that a C++ exception would unwind through?
+             * A nested call may be made by a native function invoked from JS, either by an engine call or by the embedder (e.g. UserlandFunction::invoke).
+             */
+            inline bool isOutermostCall()
+            {
+                if (this->m_heapLimitScopeDepth > 1)
+                {
+                    return false;
+                }
+                
+                HandleScope handle_scope(this->m_activeIsolationScope);
+                return StackTrace::CurrentStackTrace(this->m_activeIsolationScope, 1)->GetFrameCount() == 0;
+            }
+            
+            /**
+             * Raise a HeapBudgetExceededError if the used heap exceeds the heap budget. Should be called within a HeapLimitScope.
+             *
+             * The budget is only checked by the outermost call (so the error is never raised through JS frames).
+             * The heap usage of nested calls is checked once the outermost call completes (or by the next one).
+             */
+            inline void checkHeapLimits()
+            {
+                if (this->m_heapBudget == 0 || detail::get_used_heap_size(this->m_activeIsolationScope) <= this->m_heapBudget)
+                {
+                    return;
+                }
+                
+                if (!this->isOutermostCall())
+                {
+                    return;
+                }
+                
+                /* Give the garbage collector a chance before failing */
+                detail::low_memory_notification(this->m_activeIsolationScope);
+                
+                size_t usedHeapSize = detail::get_used_heap_size(this->m_activeIsolationScope);
+                if (usedHeapSize > this->m_heapBudget)
+                {
+                    throw HeapBudgetExceededError(usedHeapSize, this->m_heapBudget);
+                }
+            }
+            
+            inline void dispose()
+            {
+                //-------------------------------------------------
+                //  Remove ourselfs from the isolation to engine map
+                //-------------------------------------------------
+                
+                if (this->m_activeIsolationScope->GetData(V8BRIDGE_ISOLATE_DATA_SLOT) == this)
+                {
+                    this->m_activeIsolationScope->SetData(V8BRIDGE_ISOLATE_DATA_SLOT, NULL);
+                }
+                
+                //-------------------------------------------------
+                //  Dispose
+                //-------------------------------------------------
+                
+                delete this->m_nativeClassesRegistry;
+                delete this->m_structShapesRegistry;
+                delete this->m_scriptCache;
+                /* Running async calls post their results to the tasks queue, so wait for them before releasing it */
+                while (this->m_pendingAsyncCalls.load(boost::memory_order_acquire) > 0)
+                {
+                    std::this_thread::yield();
+                }
+                
+                delete this->m_pendingTasks; // futures of tasks that were not run are broken
+                delete this->m_timers;
+                delete this->m_console; // writes the queued messages
+                delete this->m_performance;
+                
+                for (TExposedTemplatesMap::iterator it = this->m_exposedTemplatesMap->begin(); it != this->m_exposedTemplatesMap->end(); ++it)
+                {
+                    it->second.Reset();
+                }
+                delete this->m_exposedTemplatesMap;
+                
+                for (TExposedObjectTemplatesMap::iterator it = this->m_exposedObjectTemplatesMap->begin(); it != this->m_exposedObjectTemplatesMap->end(); ++it)
+                {
+                    it->second.Reset();
+                }
+                delete this->m_exposedObjectTemplatesMap;
+                
+                /* Releases the exposed endpoints (and the native instances that are still bound by them) */
+                delete this->m_registeredNativeClassesMap;
+                delete this->m_registeredContractsMap;
+                
+                {
+                    /* Leave the context we've entered in initialize() (or reset()) */
+                    HandleScope handle_scope(this->m_activeIsolationScope);
+                    Local<Context>::New(this->m_activeIsolationScope, this->m_context)->Exit();
+                }
+                
+                // Dispose the persistent handles.  When noone else has any
+                // references to the objects stored in the handles they will be
+                // automatically reclaimed
+                this->m_context.Reset();
+                
+                if (this->m_ownsIsolationScope)
+                {
+                    this->m_activeIsolationScope->Exit();
+                }
+            }
+            
+            /**
+             * Set the exposed functions and classes on the global scope of the given context.
+             */
+            inline void installExposedTemplates(Handle<Context> context)
+            {
+                HandleScope handle_scope(this->m_activeIsolationScope);
+                Context::Scope context_scope(context);
+                
+                Local<Object> global = context->Global();
+                for (TExposedTemplatesMap::iterator it = this->m_exposedTemplatesMap->begin(); it != this->m_exposedTemplatesMap->end(); ++it)
+                {
+                    Local<FunctionTemplate> templ = Local<FunctionTemplate>::New(this->m_activeIsolationScope, it->second);
+                    global->Set(String::NewFromUtf8(this->m_activeIsolationScope, it->first.c_str()), templ->GetFunction());
+                }
+                
+                for (TExposedObjectTemplatesMap::iterator it = this->m_exposedObjectTemplatesMap->begin(); it != this->m_exposedObjectTemplatesMap->end(); ++it)
+                {
+                    Local<ObjectTemplate> templ = Local<ObjectTemplate>::New(this->m_activeIsolationScope, it->second);
+                    global->Set(String::NewFromUtf8(this->m_activeIsolationScope, it->first.c_str()), templ->NewInstance());
+                }
+            }
+            
+            /**
+             * Expose a built-in function template on the global scope. Like the exposed native functions,
+             * built-in functions are installed in the contexts created by createContext and reset.
+             */
+            inline void exposeBuiltin(const std::string &name, Local<FunctionTemplate> templ)
+            {
+                this->setAtGlobalScope(name, templ->GetFunction());
+                this->trackExposedTemplate(name, templ);
+            }
+            
+            /**
+             * Expose a built-in object (e.g. console), which is instantiated from the given template in every context.
+             */
+            inline void exposeBuiltin(const std::string &name, Local<ObjectTemplate> templ)
+            {
+                this->setAtGlobalScope(name, templ->NewInstance());
+                this->untrackExposedTemplate(name);
+                this->m_exposedObjectTemplatesMap->insert(std::make_pair(name, TPersistentObjectTemplate(this->m_activeIsolationScope, templ)));
+            }
+            
+            /**
+             * Track the template installed under the given JS name. The name may already be taken by a built-in
+             * (e.g. exposeFunction(..., "setTimeout")), in which case the new template replaces it in the contexts created later on.
+             */
+            inline void trackExposedTemplate(const std::string &name, Local<FunctionTemplate> templ)
+            {
+                this->untrackExposedTemplate(name);
+                this->m_exposedTemplatesMap->insert(std::make_pair(name, TPersistentTemplate(this->m_activeIsolationScope, templ)));
+            }
+            
+            /**
+             * Forget the template (function or object) that was installed under the given JS name, if any.
+             */
+            inline void untrackExposedTemplate(const std::string &name)
+            {
+                TExposedTemplatesMap::iterator templ = this->m_exposedTemplatesMap->find(name);
+                if (templ != this->m_exposedTemplatesMap->end())
+                {
+                    templ->second.Reset();
+                    this->m_exposedTemplatesMap->erase(templ);
+                }
+                
+                TExposedObjectTemplatesMap::iterator objectTempl = this->m_exposedObjectTemplatesMap->find(name);
+                if (objectTempl != this->m_exposedObjectTemplatesMap->end())
+                {
+                    objectTempl->second.Reset();
+                    this->m_exposedObjectTemplatesMap->erase(objectTempl);
+                }
+            }
+            
+            /**
+             * Set the JS stack limit of the isolation scope, relative to the current thread stack position.
+             * V8 stack limits are absolute addresses, so the limit should be set again by every thread that uses the engine.
+             */
+            inline void applyStackLimit()
+            {
+                if (this->m_stackSizeInBytes != 0)
+                {
+                    char stackPosition;
+                    this->m_activeIsolationScope->SetStackLimit(reinterpret_cast<uintptr_t>(&stackPosition) - this->m_stackSizeInBytes);
+                }
+            }
+            
+            inline void initialize(bool registerBuiltinDeclaration)
+            {
+                //-------------------------------------------------
+                // Create a temp scope
+                //-------------------------------------------------
+                HandleScope handle_scope(this->m_activeIsolationScope);
+                
+                //-------------------------------------------------
+                //  Create the active context
+                //-------------------------------------------------
+                
+                // Each processor gets its own context so different engines don't
+                // affect each other. Context::New returns a persistent handle which
+                // is what we need for the reference to remain after we return from
+                // this method. That persistent handle has to be disposed in the
+                // destructor.
+                Handle<Context> context = Context::New(this->m_activeIsolationScope, NULL);
+                context->Enter();
+                
+                this->m_context.Reset(this->m_activeIsolationScope, context);
+                this->m_scriptCache = new detail::ScriptCache(this->m_activeIsolationScope);
+                this->m_timers = new builtin::Timers(this->m_activeIsolationScope);
+                
+                //-------------------------------------------------
+                // Enter the new context so all the following operations take place
+                // within it.
+                //-------------------------------------------------
+                Context::Scope context_scope(context);
+                
+                //-------------------------------------------------
+                //  Register the engine
+                //-------------------------------------------------
+                
+                //  The engine is stored in the isolation scope data slot, so it can be resolved from any
+                //  isolate-bound code (e.g. conversions) without a global lookup. The first engine to be
+                //  created in a given isolation scope is the one that owns the slot.
+                if (this->m_activeIsolationScope->GetData(V8BRIDGE_ISOLATE_DATA_SLOT) == NULL)
+                {
+                    this->m_activeIsolationScope->SetData(V8BRIDGE_ISOLATE_DATA_SLOT, this);
+                }
+                
+                //-------------------------------------------------
+                //  Should we register some built-in functions?
+                //-------------------------------------------------
+                
+                if (registerBuiltinDeclaration)
+                {
+                    //this->exposeV8Function("sprintf", builtin::sprintf);
+                    //this->exposeV8Function("tosource", builtin::js_tosource);
+                    
+                    Local<External> timers = External::New(this->m_activeIsolationScope, this->m_timers);
+                    this->exposeBuiltin("setTimeout", FunctionTemplate::New(this->m_activeIsolationScope, &builtin::Timers::SetTimeoutCallback, timers));
+                    this->exposeBuiltin("setInterval", FunctionTemplate::New(this->m_activeIsolationScope, &builtin::Timers::SetIntervalCallback, timers));
+                    this->exposeBuiltin("clearTimeout", FunctionTemplate::New(this->m_activeIsolationScope, &builtin::Timers::ClearCallback, timers));
+                    this->exposeBuiltin("clearInterval", FunctionTemplate::New(this->m_activeIsolationScope, &builtin::Timers::ClearCallback, timers));
+                    
+                    this->m_console = new builtin::Console();
+                    Local<External> console = External::New(this->m_activeIsolationScope, this->m_console);
+                    Local<ObjectTemplate> consoleTemplate = ObjectTemplate::New(this->m_activeIsolationScope);
+                    consoleTemplate->Set(String::NewFromUtf8(this->m_activeIsolationScope, "log"), FunctionTemplate::New(this->m_activeIsolationScope, &builtin::Console::WriteCallback<builtin::Console::kLog>, console));
+                    consoleTemplate->Set(String::NewFromUtf8(this->m_activeIsolationScope, "info"), FunctionTemplate::New(this->m_activeIsolationScope, &builtin::Console::WriteCallback<builtin::Console::kInfo>, console));
+                    consoleTemplate->Set(String::NewFromUtf8(this->m_activeIsolationScope, "warn"), FunctionTemplate::New(this->m_activeIsolationScope, &builtin::Console::WriteCallback<builtin::Console::kWarn>, console));
+                    consoleTemplate->Set(String::NewFromUtf8(this->m_activeIsolationScope, "error"), FunctionTemplate::New(this->m_activeIsolationScope, &builtin::Console::WriteCallback<builtin::Console::kError>, console));
+                    this->exposeBuiltin("console", consoleTemplate);
+                    
+                    this->m_performance = new builtin::Performance();
+                    Local<External> performance = External::New(this->m_activeIsolationScope, this->m_performance);
+                    Local<ObjectTemplate> performanceTemplate = ObjectTemplate::New(this->m_activeIsolationScope);
+                    performanceTemplate->Set(String::NewFromUtf8(this->m_activeIsolationScope, "now"), FunctionTemplate::New(this->m_activeIsolationScope, &builtin::Performance::NowCallback, performance));
+                    performanceTemplate->Set(String::NewFromUtf8(this->m_activeIsolationScope, "mark"), FunctionTemplate::New(this->m_activeIsolationScope, &builtin::Performance::MarkCallback, performance));
+                    performanceTemplate->Set(String::NewFromUtf8(this->m_activeIsolationScope, "measure"), FunctionTemplate::New(this->m_activeIsolationScope, &builtin::Performance::MeasureCallback, performance));
+                    performanceTemplate->Set(String::NewFromUtf8(this->m_activeIsolationScope, "clearMarks"), FunctionTemplate::New(this->m_activeIsolationScope, &builtin::Performance::ClearMarksCallback, performance));
+                    performanceTemplate->Set(String::NewFromUtf8(this->m_activeIsolationScope, "clearMeasures"), FunctionTemplate::New(this->m_activeIsolationScope, &builtin::Performance::ClearMeasuresCallback, performance));
+                    this->exposeBuiltin("performance", performanceTemplate);
+                }
+            }
+            
             /* Types */
             typedef std::map<std::string, boost::shared_ptr<NativeEndpoint> > TNativeContractMap;
             typedef std::map<std::string, NativeEndpoint *> TNativeClassesContractMap;
-            
-            /* Static members */
-            static std::map<Isolate *, ScriptingEngine *> s_isolationToEngineMap;
+            typedef Persistent<FunctionTemplate, CopyablePersistentTraits<FunctionTemplate> > TPersistentTemplate;
+            typedef std::map<std::string, TPersistentTemplate> TExposedTemplatesMap;
+            typedef Persistent<ObjectTemplate, CopyablePersistentTraits<ObjectTemplate> > TPersistentObjectTemplate;
+            typedef std::map<std::string, TPersistentObjectTemplate> TExposedObjectTemplatesMap;
+            typedef std::vector<NativeEndpoint *> TNativeClassesRegistry; // indexed by TypeIndex
+            typedef std::vector<boost::shared_ptr<detail::StructShape> > TStructShapesRegistry; // indexed by TypeIndex
+            typedef detail::MPSCQueue<TTask> TTasksQueue;
             
             /* Private members */
             Persistent<Context> m_context;
             Isolate *m_activeIsolationScope;
+            bool m_ownsIsolationScope;
+            bool m_threadHandoff;
+            size_t m_stackSizeInBytes;
+            ArrayBuffer::Allocator *m_arrayBufferAllocator; // Owned allocator of an owned isolation scope (if any)
             
             TNativeContractMap *m_registeredContractsMap;
             TNativeClassesContractMap *m_registeredNativeClassesMap;
+            TExposedTemplatesMap *m_exposedTemplatesMap; // The exposed functions and classes templates, by their JS names
+            TExposedObjectTemplatesMap *m_exposedObjectTemplatesMap; // The built-in objects templates, by their JS names
+            TNativeClassesRegistry *m_nativeClassesRegistry;
+            TStructShapesRegistry *m_structShapesRegistry;
+            TTasksQueue *m_pendingTasks;
+            boost::atomic<size_t> m_pendingAsyncCalls;
+            builtin::Timers *m_timers;
+            builtin::Console *m_console; // NULL when the built-in declarations were not registered
+            builtin::Performance *m_performance; // NULL when the built-in declarations were not registered
+#if V8BRIDGE_HAS_PROMISES
+            boost::shared_ptr<AsyncWorkerPool> m_asyncWorkerPool;
+#endif
+            detail::ScriptCache *m_scriptCache;
+            bool m_captureStackOnTimeout;
+            
+            size_t m_heapBudget;
+            size_t m_heapLimitScopeDepth; // The number of nested HeapLimitScope
+            bool m_underMemoryPressure;
+            
+#if V8BRIDGE_HAS_IDLE_TASKS
+            Platform *m_idleTaskPlatform;
+#endif
+            size_t m_idleLowMemoryHeapThreshold;
+            std::chrono::milliseconds m_idleLowMemoryMinIdleTime;
         };
         
-        std::map<Isolate *, ScriptingEngine *> ScriptingEngine::s_isolationToEngineMap;
-        
         //==========================================================================
         //  Private helpers
         //==========================================================================
@@ -0,0 +1,517 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * This file contains the startup snapshot support.
+ *
+ * SnapshotBuilder runs a set of (prelude) scripts once in a fresh isolate and serializes the resulting heap
+ * and context into a startup blob (using V8 SnapshotCreator). New isolation scopes created from the blob
+ * (see Isolate::CreateParams::snapshot_blob) start with the prelude already evaluated.
+ *
+ * The native bindings (NativeFunction, NativeClass etc.) can be part of the snapshot as well. Their templates are created through
+ * SnapshotBindings, which routes the calls through pre-allocated slots that are registered as external references
+ * (instead of the endpoints addresses, which only exist in the process that created them). On startup, the endpoints are
+ * created again - in the same order - and bound to the same slots, while their templates are restored from the snapshot.
+ *
+ * Building:
+ *      SnapshotBindings bindings;
+ *      SnapshotBuilder builder(&bindings);
+ *      {
+ *          HandleScope handle_scope(builder.getIsolate());
+ *          builder.expose(createMathFunctions(builder.getIsolate()), "math"); // creates the NativeFunction/NativeClass endpoints
+ *      }
+ *      builder.addScript(prelude);
+ *      SnapshotBlob *blob = builder.build();
+ *
+ * Startup:
+ *      SnapshotBindings bindings;
+ *      EngineOptions options;
+ *      options.snapshotBlob = blob->get();
+ *      options.externalReferences = bindings.getExternalReferences();
+ *      ScriptingEngine *engine = new ScriptingEngine(options);
+ *      {
+ *          HandleScope handle_scope(engine->getActiveIsolationScope());
+ *          bindings.attach(engine->getActiveIsolationScope());
+ *          NativeFunction *math = createMathFunctions(engine->getActiveIsolationScope());
+ *          bindings.restore();
+ *          engine->exposeFunction(math, "math"); // the function is already on the global scope, this registers it with the engine
+ *      }
+ *
+ * Note that the prelude scripts should not keep instances of native classes, since the native instances can't be serialized.
+ *
+ * See samples/snapshot_builder.cpp for a command line tool that emits a blob file.
+ */
+
+#ifndef v8bridge_snapshot_builder_hpp
+#define v8bridge_snapshot_builder_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <stdio.h>
+#include <stdexcept>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <v8bridge/detail/code_cache.hpp>
+#include <v8bridge/native/native_endpoint.hpp>
+
+/* SnapshotCreator::AddData and Isolate::GetDataFromSnapshotOnce (used to serialize the bindings templates) are available since V8 6.8 */
+#ifndef V8BRIDGE_HAS_SNAPSHOT_CREATOR
+#   define V8BRIDGE_HAS_SNAPSHOT_CREATOR V8BRIDGE_V8_VERSION_AT_LEAST(6, 8)
+#endif
+
+/* The default number of endpoints that can be bound to a snapshot */
+#ifndef V8BRIDGE_SNAPSHOT_MAX_BINDINGS
+#   define V8BRIDGE_SNAPSHOT_MAX_BINDINGS 1024
+#endif
+
+#if V8BRIDGE_HAS_SNAPSHOT_CREATOR
+
+namespace v8
+{
+    namespace bridge
+    {
+        /**
+         * An owned startup blob.
+         */
+        class V8_DECL SnapshotBlob
+        {
+        public:
+            /* Takes the ownership of the given startup data (which should be allocated with new[], like SnapshotCreator::CreateBlob does) */
+            SnapshotBlob(StartupData data) : m_data(data) { }
+            
+            ~SnapshotBlob()
+            {
+                delete[] this->m_data.data;
+            }
+            
+            /**
+             * Load a startup blob from the given file. Returns NULL if the file could not be read.
+             */
+            inline static SnapshotBlob *FromFile(const std::string &path)
+            {
+                FILE *file = fopen(path.c_str(), "rb");
+                if (file == NULL)
+                {
+                    return NULL;
+                }
+                
+                std::vector<char> buffer;
+                char chunk[64 * 1024];
+                size_t read = 0;
+                while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+                {
+                    buffer.insert(buffer.end(), chunk, chunk + read);
+                }
+                fclose(file);
+                
+                if (buffer.empty())
+                {
+                    return NULL;
+                }
+                
+                StartupData data;
+                char *raw = new char[buffer.size()];
+                memcpy(raw, &buffer[0], buffer.size());
+                data.data = raw;
+                data.raw_size = (int)buffer.size();
+                
+                return new SnapshotBlob(data);
+            }
+            
+            /**
+             * Write the blob into the given file.
+             */
+            inline bool save(const std::string &path) const
+            {
+                FILE *file = fopen(path.c_str(), "wb");
+                if (file == NULL)
+                {
+                    return false;
+                }
+                
+                bool succeeded = fwrite(this->m_data.data, 1, (size_t)this->m_data.raw_size, file) == (size_t)this->m_data.raw_size;
+                return (fclose(file) == 0) && succeeded;
+            }
+            
+            /* The blob to assign to Isolate::CreateParams::snapshot_blob (owned by this object) */
+            inline StartupData *get() { return &this->m_data; }
+            inline size_t size() const { return (size_t)this->m_data.raw_size; }
+        private:
+            SnapshotBlob(const SnapshotBlob &);
+            SnapshotBlob &operator=(const SnapshotBlob &);
+            
+            StartupData m_data;
+        };
+        
+        /**
+         * Routes the native endpoints templates of an isolation scope through registered slots, so they can be serialized
+         * into a startup snapshot (and bound again to the endpoints of another process).
+         *
+         * The same bindings configuration (capacity and external references) must be used by the snapshot builder
+         * and by the isolation scopes that are created from the snapshot.
+         */
+        class V8_DECL SnapshotBindings : public detail::EndpointRouter
+        {
+        public:
+            SnapshotBindings(size_t capacity = V8BRIDGE_SNAPSHOT_MAX_BINDINGS) :
+            m_slots(capacity, static_cast<NativeEndpoint *>(NULL)),
+            m_boundCount(0),
+            m_isolationScope(NULL),
+            m_creator(NULL) { }
+            
+            ~SnapshotBindings()
+            {
+                this->detach();
+            }
+            
+            /**
+             * Register the address of an additional native function (or data) that is referenced from the snapshot heap.
+             * Should be called before getExternalReferences.
+             */
+            inline SnapshotBindings *addExternalReference(intptr_t reference)
+            {
+                if (!this->m_references.empty())
+                {
+                    throw std::logic_error("External references can't be added after the references list was created.");
+                }
+                
+                this->m_additionalReferences.push_back(reference);
+                return this;
+            }
+            
+            /**
+             * Get the null terminated external references list (see Isolate::CreateParams::external_references).
+             * The list is owned by the bindings, which should outlive the isolation scopes that use it.
+             */
+            inline intptr_t *getExternalReferences()
+            {
+                if (this->m_references.empty())
+                {
+                    this->m_references.push_back(reinterpret_cast<intptr_t>(&SnapshotBindings::DispatchCallback));
+                    for (TSlotsList::iterator it = this->m_slots.begin(); it != this->m_slots.end(); ++it)
+                    {
+                        this->m_references.push_back(reinterpret_cast<intptr_t>(&*it));
+                    }
+                    
+                    this->m_references.insert(this->m_references.end(), this->m_additionalReferences.begin(), this->m_additionalReferences.end());
+                    this->m_references.push_back(0);
+                }
+                
+                return &this->m_references[0];
+            }
+            
+            /**
+             * Route the templates of the endpoints that are created from now on in the given isolation scope through the bindings.
+             */
+            inline SnapshotBindings *attach(Isolate *isolationScope)
+            {
+                this->m_isolationScope = isolationScope;
+                this->m_isolationScope->SetData(V8BRIDGE_ENDPOINT_ROUTER_DATA_SLOT, static_cast<detail::EndpointRouter *>(this));
+                return this;
+            }
+            
+            /**
+             * Stop routing new endpoints templates through the bindings.
+             * The already bound endpoints remain bound (so the bindings must outlive them).
+             */
+            inline SnapshotBindings *detach()
+            {
+                if (this->m_isolationScope != NULL
+                    && this->m_isolationScope->GetData(V8BRIDGE_ENDPOINT_ROUTER_DATA_SLOT) == static_cast<detail::EndpointRouter *>(this))
+                {
+                    this->m_isolationScope->SetData(V8BRIDGE_ENDPOINT_ROUTER_DATA_SLOT, NULL);
+                }
+                
+                return this;
+            }
+            
+            /**
+             * Restore the templates of the bound endpoints from the snapshot of the attached isolation scope, then detach.
+             * Should be called once the endpoints were created (and configured) in the same order as in the snapshot builder.
+             * Throws std::runtime_error if the endpoints do not match the snapshot ones.
+             */
+            inline void restore()
+            {
+                HandleScope handle_scope(this->m_isolationScope);
+                
+                for (size_t i = 0; i < this->m_boundCount; ++i)
+                {
+                    Local<FunctionTemplate> templ;
+                    if (!this->m_isolationScope->GetDataFromSnapshotOnce<FunctionTemplate>(i).ToLocal(&templ))
+                    {
+                        std::stringstream io;
+                        io << "The endpoint #" << i << " does not exist in the snapshot. The endpoints should be created in the same order as they were when the snapshot was built.";
+                        throw std::runtime_error(io.str());
+                    }
+                    
+                    this->m_slots[i]->adoptTemplate(templ);
+                }
+                
+                this->detach();
+            }
+            
+            /* The number of bound endpoints */
+            inline size_t size() const { return this->m_boundCount; }
+            
+            virtual Local<FunctionTemplate> newTemplate(NativeEndpoint *endpoint)
+            {
+                if (this->m_boundCount == this->m_slots.size())
+                {
+                    std::stringstream io;
+                    io << "The snapshot bindings capacity (" << this->m_slots.size() << " endpoints) was exceeded.";
+                    throw std::runtime_error(io.str());
+                }
+                
+                NativeEndpoint **slot = &this->m_slots[this->m_boundCount];
+                *slot = endpoint;
+                
+                Local<FunctionTemplate> templ = FunctionTemplate::New(this->m_isolationScope, &SnapshotBindings::DispatchCallback,
+                                                                      External::New(this->m_isolationScope, slot));
+                
+                /* Keep the template in the snapshot, so it can be restored by its slot index */
+                if (this->m_creator != NULL)
+                {
+                    size_t index = this->m_creator->AddData(templ);
+                    assert(index == this->m_boundCount);
+                    (void)index;
+                }
+                
+                ++this->m_boundCount;
+                return templ;
+            }
+        private:
+            friend class SnapshotBuilder;
+            typedef std::vector<NativeEndpoint *> TSlotsList;
+            
+            SnapshotBindings(const SnapshotBindings &);
+            SnapshotBindings &operator=(const SnapshotBindings &);
+            
+            inline static void DispatchCallback(const FunctionCallbackInfo<Value>& info)
+            {
+                NativeEndpoint *endpoint = *static_cast<NativeEndpoint **>(External::Cast(*info.Data())->Value());
+                endpoint->dispatch(info);
+            }
+            
+            TSlotsList m_slots; // Never resized, since the slots addresses are the external references
+            size_t m_boundCount;
+            std::vector<intptr_t> m_additionalReferences;
+            std::vector<intptr_t> m_references;
+            Isolate *m_isolationScope;
+            SnapshotCreator *m_creator; // Set while building a snapshot
+        };
+        
+        /**
+         * Builds a startup blob by exposing native endpoints and evaluating the given scripts in a fresh isolate.
+         */
+        class V8_DECL SnapshotBuilder
+        {
+        public:
+            /**
+             * @param bindings - the bindings of the exposed endpoints (not owned). When not given, the builder uses
+             *  a default bindings configuration (i.e. SnapshotBindings()).
+             */
+            SnapshotBuilder(SnapshotBindings *bindings = NULL) : m_bindings(bindings), m_ownedBindings(NULL), m_creator(NULL)
+            {
+                if (this->m_bindings == NULL)
+                {
+                    this->m_ownedBindings = new SnapshotBindings();
+                    this->m_bindings = this->m_ownedBindings;
+                }
+            }
+            
+            ~SnapshotBuilder()
+            {
+                this->discard();
+                delete this->m_ownedBindings;
+            }
+            
+            /**
+             * Get the snapshot isolation scope (which is created on demand), in which the exposed endpoints should be created.
+             * The snapshot context is entered, so the endpoints can be created right away (within a HandleScope).
+             */
+            inline Isolate *getIsolate()
+            {
+                if (this->m_creator == NULL)
+                {
+                    this->m_creator = new SnapshotCreator(this->m_bindings->getExternalReferences());
+                    Isolate *isolate = this->m_creator->GetIsolate();
+                    
+                    this->m_bindings->attach(isolate);
+                    this->m_bindings->m_creator = this->m_creator;
+                    
+                    HandleScope handle_scope(isolate);
+                    Local<Context> context = Context::New(isolate);
+                    context->Enter();
+                    this->m_context.Reset(isolate, context);
+                }
+                
+                return this->m_creator->GetIsolate();
+            }
+            
+            /**
+             * Expose the given endpoint (NativeFunction, NativeClass etc., created in getIsolate()) on the snapshot global scope.
+             * The builder takes the ownership of the endpoint.
+             */
+            template <class TEndpoint>
+            inline SnapshotBuilder *expose(TEndpoint *endpoint, const std::string &name)
+            {
+                Isolate *isolate = this->getIsolate();
+                HandleScope handle_scope(isolate);
+                
+                Local<Context> context = Local<Context>::New(isolate, this->m_context);
+                context->Global()->Set(String::NewFromUtf8(isolate, name.c_str()), endpoint->getTemplate()->GetFunction());
+                
+                this->m_endpoints.push_back(endpoint);
+                return this;
+            }
+            
+            /**
+             * Add a script to evaluate (in the order of addition) before the snapshot is taken.
+             */
+            inline SnapshotBuilder *addScript(const std::string &scriptCode, const std::string &fileName = "")
+            {
+                this->m_scripts.push_back(std::make_pair(scriptCode, fileName));
+                return this;
+            }
+            
+            /**
+             * Register the address of a native function that is referenced from the snapshot heap
+             * (e.g. by an API function template created by the scripts owner). See SnapshotBindings::addExternalReference.
+             */
+            inline SnapshotBuilder *addExternalReference(intptr_t reference)
+            {
+                this->m_bindings->addExternalReference(reference);
+                return this;
+            }
+            
+            /**
+             * Evaluate the scripts and create the startup blob.
+             * Throws std::runtime_error if any of the scripts failed.
+             */
+            inline SnapshotBlob *build()
+            {
+                Isolate *isolate = this->getIsolate();
+                
+                {
+                    HandleScope handle_scope(isolate);
+                    Local<Context> context = Local<Context>::New(isolate, this->m_context);
+                    
+                    for (TScriptsList::const_iterator it = this->m_scripts.begin(); it != this->m_scripts.end(); ++it)
+                    {
+                        TryCatch try_catch(isolate);
+                        
+                        Local<UnboundScript> script = detail::compile_unbound_script(isolate, it->first, it->second);
+                        if (script.IsEmpty() || script->BindToCurrentContext()->Run(context).IsEmpty())
+                        {
+                            String::Utf8Value error(isolate, try_catch.Exception());
+                            
+                            std::stringstream io;
+                            io << "Could not evaluate the snapshot script " << (it->second.empty() ? "<anonymous>" : it->second)
+                               << ": " << (*error ? *error : "<unknown error>");
+                            
+                            /* The creator must create its blob before it's destroyed */
+                            this->discard();
+                            throw std::runtime_error(io.str());
+                        }
+                    }
+                    
+                    this->m_creator->SetDefaultContext(context);
+                }
+                
+                StartupData data = this->release(SnapshotCreator::FunctionCodeHandling::kKeep);
+                if (data.data == NULL)
+                {
+                    throw std::runtime_error("Could not create the snapshot blob.");
+                }
+                
+                return new SnapshotBlob(data);
+            }
+        private:
+            typedef std::vector<std::pair<std::string, std::string> > TScriptsList;
+            
+            SnapshotBuilder(const SnapshotBuilder &);
+            SnapshotBuilder &operator=(const SnapshotBuilder &);
+            
+            /**
+             * Release the endpoints and the context, create the blob and dispose the snapshot isolation scope.
+             */
+            inline StartupData release(SnapshotCreator::FunctionCodeHandling handling)
+            {
+                Isolate *isolate = this->m_creator->GetIsolate();
+                
+                for (std::vector<NativeEndpoint *>::iterator it = this->m_endpoints.begin(); it != this->m_endpoints.end(); ++it)
+                {
+                    delete *it;
+                }
+                this->m_endpoints.clear();
+                
+                {
+                    HandleScope handle_scope(isolate);
+                    Local<Context>::New(isolate, this->m_context)->Exit();
+                }
+                this->m_context.Reset();
+                
+                this->m_bindings->detach();
+                this->m_bindings->m_creator = NULL;
+                
+                StartupData data = this->m_creator->CreateBlob(handling);
+                
+                delete this->m_creator;
+                this->m_creator = NULL;
+                
+                return data;
+            }
+            
+            /**
+             * Dispose the snapshot isolation scope without keeping its blob.
+             */
+            inline void discard()
+            {
+                if (this->m_creator != NULL)
+                {
+                    /* SnapshotCreator requires CreateBlob to be called before it's destroyed */
+                    StartupData data = this->release(SnapshotCreator::FunctionCodeHandling::kClear);
+                    delete[] data.data;
+                }
+            }
+            
+            SnapshotBindings *m_bindings;
+            SnapshotBindings *m_ownedBindings;
+            SnapshotCreator *m_creator;
+            Persistent<Context> m_context;
+            std::vector<NativeEndpoint *> m_endpoints;
+            TScriptsList m_scripts;
+        };
+    }
+}
+
+#endif // V8BRIDGE_HAS_SNAPSHOT_CREATOR
+
+#endif
@@ -33,11 +33,15 @@
 
 #       include <v8bridge/detail/prefix.hpp>
 #       include <v8bridge/conversion.hpp>
+#       include <v8bridge/native/invoke_v8_handle.hpp>
+#       include <v8bridge/watchdog.hpp>
 
 #       include <boost/preprocessor/repetition.hpp>
 #       include <boost/preprocessor/iteration/iterate.hpp>
 
 #include <boost/mpl/if.hpp>
+#include <boost/range/begin.hpp>
+#include <boost/range/end.hpp>
 
 
 
@@ -60,12 +64,14 @@ namespace v8
             //=======================================================================
             
             UserlandFunction(Isolate *isolationScope, Handle<Value> functionHandle) :
-            m_isolationScope(isolationScope), m_function(isolationScope, Handle<Function>::Cast(functionHandle)) // will result in an error if the handle is not a function
+            m_isolationScope(isolationScope), m_function(isolationScope, Handle<Function>::Cast(functionHandle)), // will result in an error if the handle is not a function
+            m_timeout(0), m_captureStackOnTimeout(false)
             {
             };
             
             UserlandFunction(Isolate *isolationScope, Handle<Function> functionHandle) :
-            m_isolationScope(isolationScope), m_function(isolationScope, Handle<Function>::Cast(functionHandle))
+            m_isolationScope(isolationScope), m_function(isolationScope, Handle<Function>::Cast(functionHandle)),
+            m_timeout(0), m_captureStackOnTimeout(false)
             {
                 
             };
@@ -77,6 +83,17 @@ namespace v8
             
             inline Local<Function> getFunction() { return Local<Function>::New(this->m_isolationScope, this->m_function); }
             
+            /**
+             * Terminate invocations that run longer than the given timeout (zero, the default, disables the timeout).
+             * A terminated invocation raises a ScriptTimeoutError, see watchdog.hpp.
+             */
+            inline UserlandFunction *setTimeout(std::chrono::milliseconds timeout, bool captureStack = false)
+            {
+                this->m_timeout = timeout;
+                this->m_captureStackOnTimeout = captureStack;
+                return this;
+            }
+            
             //=======================================================================
             //  Call (just like in invoke_v8_handle)
             //=======================================================================
@@ -96,7 +113,11 @@ namespace v8
                 Handle<Value> argv[] = {};
                 TResult result;
                 
-                if (!JsToNative(this->m_isolationScope, result, callback->Call(callback, 0, argv)))
+                detail::WatchdogScope watchdog(this->m_isolationScope, this->m_timeout, this->m_captureStackOnTimeout);
+                Local<Value> returnedValue = callback->Call(callback, 0, argv);
+                watchdog.finish();
+                
+                if (!JsToNative(this->m_isolationScope, result, returnedValue))
                 {
                     std::stringstream io;
                     io << "The function returned value does not match the specified TResult (" << TypeId<TResult>().name() << ").";
@@ -117,7 +138,9 @@ namespace v8
                 Local<Function> callback = this->getFunction();
                 Handle<Value> argv[] = {};
                 
+                detail::WatchdogScope watchdog(this->m_isolationScope, this->m_timeout, this->m_captureStackOnTimeout);
                 callback->Call(callback, 0, argv);
+                watchdog.finish();
             }
             
             /**
@@ -130,7 +153,47 @@ namespace v8
                 Local<Function> callback = this->getFunction();
                 Handle<Value> argv[] = {};
                 
-                return callback->Call(callback, 0, argv);
+                detail::WatchdogScope watchdog(this->m_isolationScope, this->m_timeout, this->m_captureStackOnTimeout);
+                Handle<Value> returnedValue = callback->Call(callback, 0, argv);
+                watchdog.finish();
+                
+                return returnedValue;
+            }
+            
+            //=======================================================================
+            //  Bulk calls
+            //=======================================================================
+            
+            /**
+             * Invoke the function for each element in the given range and write the converted returned values into the given output iterator.
+             * See invoke_v8_handle_many. If the function throws, the iteration stops and a std::runtime_error is raised (like invoke does),
+             * so a partial result is never mistaken for a complete one.
+             *
+             * For example:
+             *      std::vector<int> values = ...;
+             *      std::vector<bool> flags;
+             *      filter->map<bool>(values, std::back_inserter(flags));
+             */
+            template <class TResult, class TRange, class TOutputIterator>
+            inline TOutputIterator map(const TRange &range, TOutputIterator out, size_t recycleEvery = V8BRIDGE_INVOKE_MANY_SCOPE_SIZE)
+            {
+                HandleScope handle_scope(this->m_isolationScope);
+                
+                Handle<Function> callback = this->getFunction();
+                
+                V8BRIDGE_TRY_CATCH(try_catch, this->m_isolationScope);
+                out = invoke_v8_handle_many<TResult>(this->m_isolationScope, callback, boost::begin(range), boost::end(range), out, recycleEvery);
+                
+                if (try_catch.HasCaught())
+                {
+                    String::Utf8Value exception(try_catch.Exception());
+                    
+                    std::stringstream io;
+                    io << "The function raised an exception: " << (*exception ? *exception : "<string conversion failed>");
+                    throw std::runtime_error(io.str());
+                }
+                
+                return out;
             }
             
 #       define BOOST_PP_ITERATION_PARAMS_1 (3, (1, V8_MAX_ARITY, <v8bridge/userland/userland_function.hpp>))
@@ -138,6 +201,8 @@ namespace v8
         private:
             Isolate *m_isolationScope;
             Persistent<Function> m_function;
+            std::chrono::milliseconds m_timeout;
+            bool m_captureStackOnTimeout;
         };
         
         //=======================================================================
@@ -173,7 +238,11 @@ invoke(BOOST_PP_ENUM(N, V8_BRIDGE_CALL_CONCAT_ARG, ~))
     
     TResult result;
     
-    if (!JsToNative(this->m_isolationScope, result, callback->Call(callback, N, argv)))
+    detail::WatchdogScope watchdog(this->m_isolationScope, this->m_timeout, this->m_captureStackOnTimeout);
+    Local<Value> returnedValue = callback->Call(callback, N, argv);
+    watchdog.finish();
+    
+    if (!JsToNative(this->m_isolationScope, result, returnedValue))
     {
         std::stringstream io;
         io << "The function returned value does not match the specified TResult (" << TypeId<TResult>().name() << ").";
@@ -196,7 +265,9 @@ invoke(BOOST_PP_ENUM(N, V8_BRIDGE_CALL_CONCAT_ARG, ~))
         BOOST_PP_ENUM(N, V8_BRIDGE_CALL_CONVERT_TO_V8_ARG_TYPE, ~)
     };
     
+    detail::WatchdogScope watchdog(this->m_isolationScope, this->m_timeout, this->m_captureStackOnTimeout);
     callback->Call(callback, N, argv);
+    watchdog.finish();
 }
 
 // Raw invocation
@@ -210,7 +281,11 @@ inline Handle<Value> rawInvoke(BOOST_PP_ENUM(N, V8_BRIDGE_CALL_CONCAT_ARG, ~))
         BOOST_PP_ENUM(N, V8_BRIDGE_CALL_CONVERT_TO_V8_ARG_TYPE, ~)
     };
     
-    return callback->Call(callback, N, argv);
+    detail::WatchdogScope watchdog(this->m_isolationScope, this->m_timeout, this->m_captureStackOnTimeout);
+    Handle<Value> returnedValue = callback->Call(callback, N, argv);
+    watchdog.finish();
+    
+    return returnedValue;
 }
 
 #       undef V8_BRIDGE_CALL_CONCAT_ARG
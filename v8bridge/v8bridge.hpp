@@ -36,12 +36,21 @@
 /* Conversion API */
 #include <v8bridge/conversion.hpp>
 
+/* Plain struct descriptors (V8BRIDGE_STRUCT) */
+#include <v8bridge/conversion/struct_conversion.hpp>
+
 /* Native bindings */
 #include <v8bridge/native.hpp>
 
 /* Userland bindings */
 #include <v8bridge/userland.hpp>
 
+/* Engines pool (multi-threaded serving) */
+#include <v8bridge/engine_pool.hpp>
+
+/* Startup snapshots */
+#include <v8bridge/snapshot_builder.hpp>
+
 /* General V8 development utilities */
 #include <v8bridge/utilities.hpp>
 
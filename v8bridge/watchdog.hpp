@@ -0,0 +1,351 @@
+// Copyright 2014 Quartz Technologies, Ltd. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//     * Neither the name of Quartz Technologies Ltd. nor the names of its
+//       contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef v8bridge_watchdog_hpp
+#define v8bridge_watchdog_hpp
+
+#include <v8bridge/detail/prefix.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+/* The default number of frames captured when a timed out script is terminated */
+#ifndef V8BRIDGE_WATCHDOG_STACK_TRACE_LIMIT
+#   define V8BRIDGE_WATCHDOG_STACK_TRACE_LIMIT 10
+#endif
+
+namespace v8
+{
+    namespace bridge
+    {
+        /**
+         * Raised when a script execution was terminated since it exceeded its deadline.
+         * If the stack capture was requested, getStackTrace() returns the JS stack at the moment of the termination.
+         */
+        class ScriptTimeoutError : public std::runtime_error
+        {
+        public:
+            ScriptTimeoutError(const std::string &stackTrace) :
+            std::runtime_error("The script execution was terminated since it exceeded its deadline."),
+            m_stackTrace(stackTrace) { }
+            
+            ~ScriptTimeoutError() throw() { }
+            
+            inline const std::string &getStackTrace() const { return this->m_stackTrace; }
+        private:
+            std::string m_stackTrace;
+        };
+        
+        namespace detail
+        {
+            typedef std::chrono::steady_clock TWatchdogClock;
+            
+            //-------------------------------------------------
+            //  Termination helpers (moved from V8 to Isolate in 3.28)
+            //-------------------------------------------------
+            
+            inline void terminate_execution(Isolate *isolate)
+            {
+#if V8BRIDGE_V8_VERSION_AT_LEAST(3, 28)
+                isolate->TerminateExecution();
+#else
+                V8::TerminateExecution(isolate);
+#endif
+            }
+            
+            inline void cancel_terminate_execution(Isolate *isolate)
+            {
+#if V8BRIDGE_V8_VERSION_AT_LEAST(3, 28)
+                isolate->CancelTerminateExecution();
+#else
+                V8::CancelTerminateExecution(isolate);
+#endif
+            }
+            
+            inline std::string format_current_stack_trace(Isolate *isolate, int limit)
+            {
+                HandleScope handle_scope(isolate);
+                
+                Handle<StackTrace> stackTrace = StackTrace::CurrentStackTrace(isolate, limit, StackTrace::kOverview);
+                
+                std::ostringstream io;
+                for (int i = 0; i < stackTrace->GetFrameCount(); ++i)
+                {
+                    Handle<StackFrame> frame = stackTrace->GetFrame(i);
+                    
+                    io << *String::Utf8Value(frame->GetFunctionName())
+                    << " [line: " << frame->GetLineNumber() << ", column: " << frame->GetColumn() << "]"
+                    << std::endl;
+                }
+                return io.str();
+            }
+            
+            /**
+             * A single armed deadline.
+             * fired & completed are guarded by the watchdog mutex, stackTrace is only accessed by the isolate thread.
+             */
+            struct WatchdogTimer
+            {
+                WatchdogTimer(Isolate *isolate, bool captureStack) :
+                isolate(isolate), captureStack(captureStack), fired(false), completed(false) { }
+                
+                Isolate *isolate;
+                bool captureStack;
+                bool fired;
+                bool completed;
+                std::string stackTrace;
+            };
+            
+            /**
+             * Execution watchdog, shared by all the engines in the process.
+             *
+             * A single thread waits for the earliest armed deadline (the timers are kept in a min-heap)
+             * and terminates the execution of the isolation scope that exceeded it.
+             * Disarmed timers are not removed from the heap, but skipped (and dropped) when they reach its top.
+             */
+            class V8_DECL Watchdog
+            {
+            public:
+                ~Watchdog()
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(this->m_mutex);
+                        this->m_stopping = true;
+                    }
+                    this->m_condition.notify_all();
+                    
+                    if (this->m_thread.joinable())
+                    {
+                        this->m_thread.join();
+                    }
+                }
+                
+                inline static Watchdog &Shared()
+                {
+                    static Watchdog watchdog;
+                    return watchdog;
+                }
+                
+                inline void arm(const boost::shared_ptr<WatchdogTimer> &timer, TWatchdogClock::time_point deadline)
+                {
+                    std::lock_guard<std::mutex> lock(this->m_mutex);
+                    
+                    /* The thread is created on the first use */
+                    if (!this->m_thread.joinable())
+                    {
+                        this->m_thread = std::thread(&Watchdog::run, this);
+                    }
+                    
+                    this->dropCompleted();
+                    
+                    bool earliest = this->m_timers.empty() || deadline < this->m_timers.top().deadline;
+                    this->m_timers.push(Entry(deadline, timer));
+                    
+                    if (earliest)
+                    {
+                        this->m_condition.notify_one();
+                    }
+                }
+                
+                /**
+                 * Disarm the given timer. Returns true if the timer has already fired.
+                 * Once disarmed, the timer would not terminate the isolation scope execution.
+                 */
+                inline bool disarm(const boost::shared_ptr<WatchdogTimer> &timer)
+                {
+                    std::lock_guard<std::mutex> lock(this->m_mutex);
+                    
+                    timer->completed = true;
+                    return timer->fired;
+                }
+            private:
+                struct Entry
+                {
+                    Entry(TWatchdogClock::time_point deadline, const boost::shared_ptr<WatchdogTimer> &timer) : deadline(deadline), timer(timer) { }
+                    
+                    TWatchdogClock::time_point deadline;
+                    boost::shared_ptr<WatchdogTimer> timer;
+                    
+                    /* Reversed, so the priority queue top is the earliest deadline */
+                    inline bool operator<(const Entry &other) const { return this->deadline > other.deadline; }
+                };
+                
+                Watchdog() : m_stopping(false) { }
+                Watchdog(const Watchdog &);
+                Watchdog &operator=(const Watchdog &);
+                
+                inline void dropCompleted()
+                {
+                    while (!this->m_timers.empty() && this->m_timers.top().timer->completed)
+                    {
+                        this->m_timers.pop();
+                    }
+                }
+                
+                inline void run()
+                {
+                    std::unique_lock<std::mutex> lock(this->m_mutex);
+                    
+                    while (!this->m_stopping)
+                    {
+                        this->dropCompleted();
+                        
+                        if (this->m_timers.empty())
+                        {
+                            this->m_condition.wait(lock);
+                            continue;
+                        }
+                        
+                        if (TWatchdogClock::now() < this->m_timers.top().deadline)
+                        {
+                            this->m_condition.wait_until(lock, this->m_timers.top().deadline);
+                            continue;
+                        }
+                        
+                        boost::shared_ptr<WatchdogTimer> timer = this->m_timers.top().timer;
+                        this->m_timers.pop();
+                        
+                        timer->fired = true;
+                        
+                        if (timer->captureStack)
+                        {
+                            /* The stack can only be captured on the isolate thread, so the termination is deferred to the interrupt */
+                            timer->isolate->RequestInterrupt(&Watchdog::InterruptCallback, new boost::shared_ptr<WatchdogTimer>(timer));
+                        }
+                        else
+                        {
+                            terminate_execution(timer->isolate);
+                        }
+                    }
+                }
+                
+                inline static void InterruptCallback(Isolate *isolate, void *data)
+                {
+                    boost::shared_ptr<WatchdogTimer> *ptr = static_cast<boost::shared_ptr<WatchdogTimer> *>(data);
+                    boost::shared_ptr<WatchdogTimer> timer = *ptr;
+                    delete ptr;
+                    
+                    {
+                        std::lock_guard<std::mutex> lock(Watchdog::Shared().m_mutex);
+                        if (timer->completed)
+                        {
+                            return; // the execution ended before the interrupt was served
+                        }
+                    }
+                    
+                    timer->stackTrace = format_current_stack_trace(isolate, V8BRIDGE_WATCHDOG_STACK_TRACE_LIMIT);
+                    terminate_execution(isolate);
+                }
+                
+                std::mutex m_mutex;
+                std::condition_variable m_condition;
+                std::priority_queue<Entry> m_timers;
+                std::thread m_thread;
+                bool m_stopping;
+            };
+            
+            /**
+             * Enforce a deadline on the executions done during the scope lifetime.
+             *
+             * Call finish() once the execution returned, in order to raise a ScriptTimeoutError if the deadline was exceeded
+             * (the destructor only disarms the deadline, so it can be used safely on exceptions).
+             * A scope created with a zero timeout does nothing.
+             */
+            class V8_DECL WatchdogScope
+            {
+            public:
+                WatchdogScope(Isolate *isolate, TWatchdogClock::time_point deadline, bool captureStack = false) : m_isolate(isolate)
+                {
+                    this->arm(deadline, captureStack);
+                }
+                
+                WatchdogScope(Isolate *isolate, std::chrono::milliseconds timeout, bool captureStack = false) : m_isolate(isolate)
+                {
+                    if (timeout.count() > 0)
+                    {
+                        this->arm(TWatchdogClock::now() + timeout, captureStack);
+                    }
+                }
+                
+                ~WatchdogScope()
+                {
+                    this->disarm();
+                }
+                
+                inline void finish()
+                {
+                    if (this->disarm())
+                    {
+                        throw ScriptTimeoutError(this->m_stackTrace);
+                    }
+                }
+            private:
+                WatchdogScope(const WatchdogScope &);
+                WatchdogScope &operator=(const WatchdogScope &);
+                
+                inline void arm(TWatchdogClock::time_point deadline, bool captureStack)
+                {
+                    this->m_timer.reset(new WatchdogTimer(this->m_isolate, captureStack));
+                    Watchdog::Shared().arm(this->m_timer, deadline);
+                }
+                
+                inline bool disarm()
+                {
+                    if (!this->m_timer)
+                    {
+                        return false;
+                    }
+                    
+                    bool fired = Watchdog::Shared().disarm(this->m_timer);
+                    if (fired)
+                    {
+                        /* Let the isolation scope run scripts again */
+                        cancel_terminate_execution(this->m_isolate);
+                        this->m_stackTrace = this->m_timer->stackTrace;
+                    }
+                    
+                    this->m_timer.reset();
+                    return fired;
+                }
+                
+                Isolate *m_isolate;
+                boost::shared_ptr<WatchdogTimer> m_timer;
+                std::string m_stackTrace;
+            };
+        }
+    }
+}
+
+#endif